@@ -0,0 +1,193 @@
+// BERTOLINI Garice
+// Micro-benchmarks, ./bench <name> files...
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "files.hpp"
+#include "coloring.hpp"
+#include "dynamic.hpp"
+
+double since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Scalar Segment::cross against the batch kernel, over every pair in the
+// x-overlap range of the sweep. Results must match bit for bit.
+bool benchCross(const std::string &fn)
+{
+    std::vector<Segment> segments = readSegments(fn);
+    SweepOrder order(segments);
+
+    std::vector<bool> scalar, batchScalar, batch;
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < order.size(); k++)
+        for (int l = k + 1, end = order.overlapEnd(k); l < end; l++)
+            scalar.push_back(order.cross(k, l));
+    double tScalar = since(start);
+
+    auto runBatch = [&](std::vector<bool> &out, auto kernel) {
+        auto start = std::chrono::steady_clock::now();
+        for (int k = 0; k < order.size(); k++)
+        {
+            int end = order.overlapEnd(k), l = k + 1;
+            for (; l + 4 <= end; l += 4)
+            {
+                int mask = kernel(k, l);
+                for (int b = 0; b < 4; b++)
+                    out.push_back(mask >> b & 1);
+            }
+            for (; l < end; l++)
+                out.push_back(order.cross(k, l));
+        }
+        return since(start);
+    };
+    double tBatchScalar = runBatch(batchScalar, [&](int k, int l) { return order.crossBatchScalar(k, l); });
+    double tBatch = runBatch(batch, [&](int k, int l) { return order.crossBatch(k, l); });
+
+    double pairs = scalar.size();
+    std::cout << fn << ": " << scalar.size() << " pairs"
+              << (order.batchable ? "" : " (coordinates too large for the AVX2 kernel)") << std::endl;
+    std::cout << "  cross        " << tScalar << "s " << tScalar * 1e9 / pairs << "ns/pair" << std::endl;
+    std::cout << "  batch scalar " << tBatchScalar << "s " << tBatchScalar * 1e9 / pairs << "ns/pair" << std::endl;
+#ifdef __AVX2__
+    std::cout << "  batch AVX2   ";
+#else
+    std::cout << "  batch        ";
+#endif
+    std::cout << tBatch << "s " << tBatch * 1e9 / pairs << "ns/pair" << std::endl;
+
+    bool same = scalar == batchScalar && scalar == batch;
+    std::cout << "  " << (same ? "identical results" : "results differ!") << std::endl;
+    return same;
+}
+
+// Loads the instance in a child process so that each mode reports its own
+// peak resident memory
+bool benchLoad(const std::string &fn)
+{
+    std::cout << fn << ":" << std::endl;
+    SegmentArrays reference = read_arrays(fn, LoadMode::Dom);
+    bool same = true;
+
+    for (auto [mode, name] : {std::pair{LoadMode::Dom, "DOM   "}, {LoadMode::Stream, "stream"}, {LoadMode::Mapped, "mmap  "}})
+    {
+        std::cout << std::flush;
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            auto start = std::chrono::steady_clock::now();
+            SegmentArrays arrays = read_arrays(fn, mode);
+            double t = since(start);
+            size_t bytes = (arrays.x.size() + arrays.y.size() + arrays.edge_i.size() + arrays.edge_j.size()) * sizeof(int);
+            std::cout << "  " << name << " " << t << "s, arrays " << bytes / 1024 << "KB";
+            bool ok = arrays.x == reference.x && arrays.y == reference.y
+                   && arrays.edge_i == reference.edge_i && arrays.edge_j == reference.edge_j;
+            std::cout << std::flush;
+            _exit(ok ? 0 : 1);
+        }
+
+        int status;
+        struct rusage usage;
+        wait4(pid, &status, 0, &usage);
+        std::cout << ", peak RSS " << usage.ru_maxrss << "KB" << std::endl;
+        same &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    std::cout << "  " << (same ? "identical arrays" : "arrays differ!") << std::endl;
+    return same;
+}
+
+// Removes then reinserts random segments one at a time, against rebuilding
+// the graph and recoloring from scratch after each change
+bool benchDynamic(const std::string &fn)
+{
+    const int updates = 200;
+    std::vector<Segment> segments = readSegments(fn);
+
+    auto start = std::chrono::steady_clock::now();
+    DenseGraph g(segments.size(), crossingPairs(segments, BuildMode::Batch));
+    int fullColors = countColors(dsaturColor(g));
+    double tFull = since(start);
+
+    DynamicColoring dynamic(segments);
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> pick(0, segments.size() - 1);
+    double tErase = 0, tInsert = 0;
+    for (int i = 0; i < updates; i++)
+    {
+        int v = pick(rng);
+        if (!dynamic.isAlive(v))
+            continue;
+        Segment s = dynamic.segment(v);
+        start = std::chrono::steady_clock::now();
+        dynamic.erase(v);
+        tErase += since(start);
+        start = std::chrono::steady_clock::now();
+        dynamic.insert(s);
+        tInsert += since(start);
+    }
+
+    // Graph rebuilt from the alive segments, same edge count and the
+    // coloring must fit it
+    std::vector<int> ids;
+    std::vector<Segment> current;
+    for (int v = 0; v < dynamic.capacity(); v++)
+    {
+        if (dynamic.isAlive(v))
+        {
+            ids.push_back(v);
+            current.push_back(dynamic.segment(v));
+        }
+    }
+    bool valid = true;
+    long edges = 0;
+    for (const auto &[i, j] : crossingPairs(current, BuildMode::Batch))
+    {
+        valid &= dynamic.coloring()[ids[i]] != dynamic.coloring()[ids[j]];
+        edges++;
+    }
+    long entries = 0;
+    for (int v : ids)
+        entries += dynamic.neighbors(v).size();
+    valid &= entries == 2 * edges;
+
+    std::cout << fn << ": full rebuild and DSatur " << tFull * 1e3 << "ms, " << fullColors << " colors" << std::endl;
+    std::cout << "  erase  " << tErase * 1e3 / updates << "ms per update" << std::endl;
+    std::cout << "  insert " << tInsert * 1e3 / updates << "ms per update, "
+              << dynamic.kempeSwaps << " Kempe swaps, " << dynamic.newColors << " new colors" << std::endl;
+    std::cout << "  " << dynamic.countColors() << " colors after " << updates << " updates, "
+              << (valid ? "coloring valid" : "coloring invalid!") << std::endl;
+    return valid;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "./bench cross|load|dynamic files..." << std::endl;
+        return 1;
+    }
+
+    std::string name = argv[1];
+    bool ok = true;
+    for (int i = 2; i < argc; i++)
+    {
+        if (name == "cross")
+            ok &= benchCross(argv[i]);
+        else if (name == "load")
+            ok &= benchLoad(argv[i]);
+        else if (name == "dynamic")
+            ok &= benchDynamic(argv[i]);
+        else
+        {
+            std::cout << "Unknown benchmark " << name << std::endl;
+            return 1;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+#!/bin/bash
+
+g++ bench.cpp -std=c++20 -pthread -Wfatal-errors -o bench -O3 -march=native
+./bench cross `ls -Sr input/*.json`
+./bench load `ls -Sr input/*.json`
+./bench dynamic `ls -Sr input/*.json`
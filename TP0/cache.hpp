@@ -0,0 +1,111 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include "graph.hpp"
+#include "files.hpp"
+
+// Conflict graph cache, next to the instance:
+//   CacheHeader
+//   int32 offsets[vertices + 1]
+//   int32 targets[offsets[vertices]]
+// The graph is rebuilt whenever hash no longer matches the JSON file.
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vertices;
+    uint64_t hash;
+    uint64_t entries;
+};
+
+const char cacheMagic[8] = {'S', 'E', 'G', 'G', 'R', 'A', 'P', 'H'};
+const uint32_t cacheVersion = 1;
+
+// FNV-1a of the whole file, 0 if it cannot be read
+uint64_t hashFile(const std::string &fn)
+{
+    MappedFile file(fn);
+    if (!file.is_open())
+        return 0;
+
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < file.size(); i++)
+    {
+        h ^= (unsigned char)file.data()[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// a.instance.json -> a.instance.graph
+std::string cacheFilename(std::string fn)
+{
+    if (fn.ends_with(".json"))
+        fn.replace(fn.end() - 4, fn.end(), "graph");
+    else
+        fn += ".graph";
+    return fn;
+}
+
+std::optional<DenseGraph> loadCachedGraph(const std::string &fn, uint64_t hash)
+{
+    MappedFile file(cacheFilename(fn));
+    if (!file.is_open() || file.size() < sizeof(CacheHeader))
+        return {};
+
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0
+        || header.version != cacheVersion || header.hash != hash)
+        return {};
+
+    size_t offsetBytes = (header.vertices + 1) * sizeof(int32_t);
+    size_t targetBytes = header.entries * sizeof(int32_t);
+    if (file.size() != sizeof(header) + offsetBytes + targetBytes)
+        return {};
+
+    const char *data = file.data() + sizeof(header);
+    std::vector<int> offsets(header.vertices + 1), targets(header.entries);
+    std::memcpy(offsets.data(), data, offsetBytes);
+    std::memcpy(targets.data(), data + offsetBytes, targetBytes);
+    if (offsets[0] != 0 || (uint64_t)offsets.back() != header.entries)
+        return {};
+    for (uint32_t v = 0; v < header.vertices; v++)
+        if (offsets[v] > offsets[v + 1])
+            return {};
+    for (int u : targets)
+        if (u < 0 || (uint32_t)u >= header.vertices)
+            return {};
+
+    return DenseGraph(std::move(offsets), std::move(targets));
+}
+
+// Written to a temporary file then renamed, so a concurrent run never
+// maps a half written cache
+bool saveCachedGraph(const std::string &fn, uint64_t hash, const DenseGraph &g)
+{
+    CacheHeader header;
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.vertices = g.countVertices();
+    header.hash = hash;
+    header.entries = g.csrTargets().size();
+
+    std::string out = cacheFilename(fn);
+    std::string tmp = out + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+           && fwrite(g.csrOffsets().data(), sizeof(int), g.csrOffsets().size(), f) == g.csrOffsets().size()
+           && fwrite(g.csrTargets().data(), sizeof(int), g.csrTargets().size(), f) == g.csrTargets().size();
+    ok &= fclose(f) == 0;
+    return ok && std::rename(tmp.c_str(), out.c_str()) == 0;
+}
+
+#endif
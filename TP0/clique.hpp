@@ -0,0 +1,191 @@
+#ifndef CLIQUE_HPP
+#define CLIQUE_HPP
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+#include "graph.hpp"
+
+// Heuristic maximum clique, a lower bound on the number of colors. For the
+// highest degree vertices v, a clique is grown greedily inside N(v) then
+// improved by add and swap moves on a bit matrix of N(v).
+class CliqueFinder
+{
+    const DenseGraph &g;
+    std::vector<int> best;
+    std::mt19937 rng;
+
+    // Local bit matrix of the neighborhood of v
+    int d = 0, words = 0;
+    std::vector<int> local;
+    std::vector<uint64_t> rows;
+
+    bool adjacent(int x, int y) const
+    {
+        return rows[(size_t)x * words + y / 64] >> (y % 64) & 1;
+    }
+
+    void buildRows(int v)
+    {
+        std::span<const int> neigh = g.neighbors(v);
+        local.assign(neigh.begin(), neigh.end());
+        d = local.size();
+        words = (d + 63) / 64;
+        rows.assign((size_t)d * words, 0);
+
+        // Sorted lists on both sides, so one merge per row
+        for (int x = 0; x < d; x++)
+        {
+            std::span<const int> nx = g.neighbors(local[x]);
+            auto it = nx.begin();
+            for (int y = 0; y < d && it != nx.end(); y++)
+            {
+                it = std::lower_bound(it, nx.end(), local[y]);
+                if (it != nx.end() && *it == local[y])
+                    rows[(size_t)x * words + y / 64] |= uint64_t(1) << (y % 64);
+            }
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    // Clique in the local matrix, then v itself
+    std::vector<int> search(int v, int iterations, Clock::time_point deadline)
+    {
+        buildRows(v);
+
+        std::vector<bool> inClique(d, false);
+        std::vector<int> missing(d, 0); // Clique members not adjacent to x
+        std::vector<long> tabu(d, 0);
+        int size = 0;
+
+        auto add = [&](int x) {
+            inClique[x] = true;
+            size++;
+            for (int z = 0; z < d; z++)
+                if (z != x && !adjacent(x, z))
+                    missing[z]++;
+        };
+        auto remove = [&](int x) {
+            inClique[x] = false;
+            size--;
+            for (int z = 0; z < d; z++)
+                if (z != x && !adjacent(x, z))
+                    missing[z]--;
+        };
+
+        // Greedy: the candidate keeping the most candidates
+        std::vector<uint64_t> candidates(words, 0);
+        for (int x = 0; x < d; x++)
+            candidates[x / 64] |= uint64_t(1) << (x % 64);
+        while (true)
+        {
+            int pick = -1, kept = -1;
+            for (int w = 0; w < words; w++)
+            {
+                for (uint64_t bits = candidates[w]; bits; bits &= bits - 1)
+                {
+                    int x = w * 64 + std::countr_zero(bits);
+                    int count = 0;
+                    for (int i = 0; i < words; i++)
+                        count += std::popcount(candidates[i] & rows[(size_t)x * words + i]);
+                    if (count > kept)
+                    {
+                        kept = count;
+                        pick = x;
+                    }
+                }
+            }
+            if (pick == -1)
+                break;
+            add(pick);
+            for (int i = 0; i < words; i++)
+                candidates[i] &= rows[(size_t)pick * words + i];
+        }
+
+        std::vector<bool> bestLocal = inClique;
+        int bestSize = size;
+
+        // Local search: add a vertex adjacent to the whole clique, else swap
+        // one in for its only non neighbor in the clique
+        for (long it = 1; it <= iterations && (it % 64 != 0 || Clock::now() < deadline); it++)
+        {
+            std::vector<int> adds, swaps;
+            for (int x = 0; x < d; x++)
+            {
+                if (inClique[x])
+                    continue;
+                if (missing[x] == 0)
+                    adds.push_back(x);
+                else if (missing[x] == 1 && tabu[x] <= it)
+                    swaps.push_back(x);
+            }
+
+            if (!adds.empty())
+                add(adds[std::uniform_int_distribution<size_t>(0, adds.size() - 1)(rng)]);
+            else if (!swaps.empty())
+            {
+                int x = swaps[std::uniform_int_distribution<size_t>(0, swaps.size() - 1)(rng)];
+                int y = 0;
+                while (!inClique[y] || adjacent(x, y))
+                    y++;
+                remove(y);
+                add(x);
+                tabu[y] = it + 7;
+            }
+            else
+                break;
+
+            if (size > bestSize)
+            {
+                bestSize = size;
+                bestLocal = inClique;
+            }
+        }
+
+        std::vector<int> clique{v};
+        for (int x = 0; x < d; x++)
+            if (bestLocal[x])
+                clique.push_back(local[x]);
+        return clique;
+    }
+
+public:
+    CliqueFinder(const DenseGraph &_g, unsigned seed = 1) : g(_g), rng(seed)
+    {
+    }
+
+    // Tries the vertices by decreasing degree until the time is up. A
+    // vertex of degree d is in no clique larger than d + 1, so the search
+    // also stops once no remaining vertex can do better.
+    std::vector<int> run(double seconds)
+    {
+        auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        std::vector<int> order(g.countVertices());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int u, int v) {
+            return g.degree(u) > g.degree(v);
+        });
+
+        for (int v : order)
+        {
+            if (g.degree(v) + 1 <= (int)best.size() || Clock::now() >= deadline)
+                break;
+            std::vector<int> clique = search(v, 2 * g.degree(v), deadline);
+            if (clique.size() > best.size())
+                best = clique;
+        }
+        return best;
+    }
+
+    const std::vector<int> &clique() const
+    {
+        return best;
+    }
+};
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef COLORING_HPP
+#define COLORING_HPP
+
+#include <vector>
+#include <queue>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include "graph.hpp"
+#include "parallel.hpp"
+
+// color[v] for vertices 0..n-1, -1 if uncolored
+using Coloring = std::vector<int>;
+
+int countColors(const Coloring &color)
+{
+    int maxColor = -1;
+    for (int c : color)
+        maxColor = std::max(maxColor, c);
+    return maxColor + 1;
+}
+
+// Set of colors seen around a vertex, one bit per color
+class ColorMask
+{
+    std::vector<uint64_t> words;
+
+public:
+    // Returns true if c was not in the set yet
+    bool insert(int c)
+    {
+        size_t w = c / 64;
+        if (w >= words.size())
+            words.resize(w + 1, 0);
+        uint64_t bit = uint64_t(1) << (c % 64);
+        if (words[w] & bit)
+            return false;
+        words[w] |= bit;
+        return true;
+    }
+
+    bool contains(int c) const
+    {
+        size_t w = c / 64;
+        return w < words.size() && (words[w] >> (c % 64) & 1);
+    }
+
+    int firstAvailable() const
+    {
+        size_t w = 0;
+        while (w < words.size() && words[w] == ~uint64_t(0))
+            w++;
+        return w * 64 + (w < words.size() ? std::countr_one(words[w]) : 0);
+    }
+};
+
+// Uncolored vertices by saturation, then degree. One max-heap per
+// saturation level; entries left behind when a vertex moves up a level
+// are skipped when they reach the top.
+class SaturationQueue
+{
+    std::vector<std::priority_queue<std::pair<int, int>>> buckets;
+    const std::vector<int> &saturation;
+    int top = -1;
+
+public:
+    SaturationQueue(int maxSaturation, const std::vector<int> &_saturation)
+        : buckets(maxSaturation + 1), saturation(_saturation)
+    {
+    }
+
+    void push(int v, int degree)
+    {
+        int s = saturation[v];
+        buckets[s].push({degree, -v});
+        top = std::max(top, s);
+    }
+
+    // Returns -1 when empty, done[v] marks vertices already taken
+    int pop(const std::vector<bool> &done)
+    {
+        while (top >= 0)
+        {
+            if (buckets[top].empty())
+            {
+                top--;
+                continue;
+            }
+            int v = -buckets[top].top().second;
+            buckets[top].pop();
+            if (!done[v] && saturation[v] == top)
+                return v;
+        }
+        return -1;
+    }
+};
+
+// DSatur: always colors the uncolored vertex seeing the most distinct
+// colors, ties broken by degree then smallest id. O((V+E) log V).
+template <class G>
+Coloring dsaturColor(const G &g)
+{
+    int n = g.countVertices();
+    Coloring color(n, -1);
+    std::vector<ColorMask> neighborColors(n);
+    std::vector<int> saturation(n, 0);
+    std::vector<bool> done(n, false);
+
+    SaturationQueue queue(std::max(0, g.maxDegree()), saturation);
+    for (int v = 0; v < n; v++)
+        queue.push(v, g.degree(v));
+
+    for (int v = queue.pop(done); v != -1; v = queue.pop(done))
+    {
+        done[v] = true;
+        int c = neighborColors[v].firstAvailable();
+        color[v] = c;
+
+        for (int u : g.neighbors(v))
+        {
+            if (!done[u] && neighborColors[u].insert(c))
+            {
+                saturation[u]++;
+                queue.push(u, g.degree(u));
+            }
+        }
+    }
+
+    return color;
+}
+
+struct SpeculativeStats
+{
+    std::vector<int> conflicts; // Vertices recolored after each round
+    double seconds = 0;
+};
+
+// Gebremedhin-Manne speculative coloring. Each round, workers first-fit
+// color their share of the worklist while reading neighbor colors without
+// locking, then look for neighbors that ended up with the same color. Of
+// each such pair, the vertex later in largest degree order goes back to
+// the worklist for the next round.
+template <class G>
+Coloring speculativeColor(const G &g, ThreadPool &pool, SpeculativeStats &stats)
+{
+    const int blockSize = 256;
+    auto start = std::chrono::steady_clock::now();
+    int n = g.countVertices();
+
+    std::vector<int> todo(n), rank(n);
+    std::iota(todo.begin(), todo.end(), 0);
+    std::stable_sort(todo.begin(), todo.end(), [&](int u, int v) {
+        return g.degree(u) > g.degree(v);
+    });
+    for (int i = 0; i < n; i++)
+        rank[todo[i]] = i;
+
+    std::vector<std::atomic<int>> color(n);
+    for (auto &c : color)
+        c.store(-1, std::memory_order_relaxed);
+
+    // forbidden[t][c] == stamp when c is taken around the vertex thread t
+    // colors; stamps are unique per (round, vertex) so that a vertex
+    // recolored in a later round does not see its earlier neighborhood
+    std::vector<std::vector<long long>> forbidden(pool.size(), std::vector<long long>(std::max(0, g.maxDegree()) + 2, 0));
+    std::vector<std::vector<int>> again(pool.size());
+
+    for (long long round = 0; !todo.empty(); round++)
+    {
+        int blocks = (todo.size() + blockSize - 1) / blockSize;
+        pool.run(blocks, [&](int t, int b) {
+            int end = std::min<int>(todo.size(), (b + 1) * blockSize);
+            for (int i = b * blockSize; i < end; i++)
+            {
+                int v = todo[i];
+                long long stamp = round * n + v + 1;
+                for (int u : g.neighbors(v))
+                {
+                    int c = color[u].load(std::memory_order_relaxed);
+                    if (c >= 0)
+                        forbidden[t][c] = stamp;
+                }
+                int c = 0;
+                while (forbidden[t][c] == stamp)
+                    c++;
+                color[v].store(c, std::memory_order_relaxed);
+            }
+        });
+
+        pool.run(blocks, [&](int t, int b) {
+            int end = std::min<int>(todo.size(), (b + 1) * blockSize);
+            for (int i = b * blockSize; i < end; i++)
+            {
+                int v = todo[i];
+                int c = color[v].load(std::memory_order_relaxed);
+                for (int u : g.neighbors(v))
+                {
+                    if (rank[u] < rank[v] && color[u].load(std::memory_order_relaxed) == c)
+                    {
+                        again[t].push_back(v);
+                        break;
+                    }
+                }
+            }
+        });
+
+        todo.clear();
+        for (std::vector<int> &buffer : again)
+        {
+            todo.insert(todo.end(), buffer.begin(), buffer.end());
+            buffer.clear();
+        }
+        std::sort(todo.begin(), todo.end(), [&](int u, int v) { return rank[u] < rank[v]; });
+        for (int v : todo)
+            color[v].store(-1, std::memory_order_relaxed);
+        stats.conflicts.push_back(todo.size());
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return Coloring(color.begin(), color.end());
+}
+
+#endif
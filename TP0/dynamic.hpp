@@ -0,0 +1,343 @@
+#ifndef DYNAMIC_HPP
+#define DYNAMIC_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <climits>
+#include "graph.hpp"
+#include "files.hpp"
+#include "coloring.hpp"
+
+// Uniform grid where a segment is stored in every cell it passes through,
+// so two crossing segments always share a cell
+class SegmentGrid
+{
+    double cellSize;
+    std::unordered_map<i64, std::vector<int>> cells;
+
+    i64 cellOf(double c) const
+    {
+        return (i64)std::floor(c / cellSize);
+    }
+
+    static i64 key(i64 cx, i64 cy)
+    {
+        return (cx << 32) ^ (cy & 0xffffffff);
+    }
+
+    // Column by column, the y range of the segment inside the column,
+    // widened by one unit so that points on cell borders hit both cells
+    template <class F>
+    void forEachCell(const Segment &s, F f) const
+    {
+        const Point &p = s.get_p(), &q = s.get_q();
+        for (i64 cx = cellOf(p.x); cx <= cellOf(q.x); cx++)
+        {
+            double ya = p.y, yb = q.y;
+            if (p.x != q.x)
+            {
+                double xa = std::max<double>(p.x, cx * cellSize);
+                double xb = std::min<double>(q.x, (cx + 1) * cellSize);
+                double slope = double(q.y - p.y) / (q.x - p.x);
+                ya = p.y + slope * (xa - p.x);
+                yb = p.y + slope * (xb - p.x);
+            }
+            for (i64 cy = cellOf(std::min(ya, yb) - 1); cy <= cellOf(std::max(ya, yb) + 1); cy++)
+                f(key(cx, cy));
+        }
+    }
+
+public:
+    SegmentGrid(double _cellSize) : cellSize(std::max(_cellSize, 1.0))
+    {
+    }
+
+    void insert(int id, const Segment &s)
+    {
+        forEachCell(s, [&](i64 k) { cells[k].push_back(id); });
+    }
+
+    void erase(int id, const Segment &s)
+    {
+        forEachCell(s, [&](i64 k) {
+            std::vector<int> &cell = cells.at(k);
+            std::erase(cell, id);
+            if (cell.empty())
+                cells.erase(k);
+        });
+    }
+
+    // Calls f(id) for every segment sharing a cell with s, possibly twice
+    template <class F>
+    void forEachCandidate(const Segment &s, F f) const
+    {
+        forEachCell(s, [&](i64 k) {
+            auto it = cells.find(k);
+            if (it != cells.end())
+                for (int id : it->second)
+                    f(id);
+        });
+    }
+};
+
+// Segments inserted and removed in small batches. Only the crossings of
+// the changed segment are recomputed and only vertices around it are
+// recolored, with Kempe chain swaps before a new color is opened.
+class DynamicColoring
+{
+    std::vector<Segment> segments;
+    std::vector<bool> alive;
+    std::vector<int> freeIds;
+    std::vector<std::vector<int>> adj;
+    Coloring color;
+    std::vector<int> classSize;
+    SegmentGrid grid;
+    std::vector<int> seen; // Query stamps, seen[id] == stamp if already met
+    int stamp = 0;
+    int maxChain;
+
+public:
+    long kempeSwaps = 0, newColors = 0;
+
+private:
+    void setColor(int v, int c)
+    {
+        if (color[v] >= 0)
+            classSize[color[v]]--;
+        color[v] = c;
+        if (c >= (int)classSize.size())
+            classSize.resize(c + 1, 0);
+        classSize[c]++;
+    }
+
+    // Drops empty classes at the top of the palette
+    void shrinkPalette()
+    {
+        while (!classSize.empty() && classSize.back() == 0)
+            classSize.pop_back();
+    }
+
+    ColorMask neighborColors(int v) const
+    {
+        ColorMask mask;
+        for (int u : adj[v])
+            mask.insert(color[u]);
+        return mask;
+    }
+
+    // Vertices reachable from u through colors a and b, empty if more
+    // than maxChain
+    std::vector<int> kempeChain(int u, int a, int b)
+    {
+        std::vector<int> chain{u};
+        seen[u] = ++stamp;
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            int x = chain[i];
+            int other = color[x] == a ? b : a;
+            for (int y : adj[x])
+            {
+                if (color[y] == other && seen[y] != stamp)
+                {
+                    seen[y] = stamp;
+                    chain.push_back(y);
+                    if ((int)chain.size() > maxChain)
+                        return {};
+                }
+            }
+        }
+        return chain;
+    }
+
+    void swapChain(const std::vector<int> &chain, int a, int b)
+    {
+        for (int x : chain)
+            setColor(x, color[x] == a ? b : a);
+    }
+
+    // Tries to free a color of the palette around v with one Kempe swap:
+    // if v has a single neighbor u colored a, swapping the (a, b) chain of u
+    // frees a unless the chain reaches another neighbor of v
+    int kempeRepair(int v)
+    {
+        int k = classSize.size();
+        std::vector<int> count(k, 0), witness(k, -1);
+        for (int u : adj[v])
+        {
+            count[color[u]]++;
+            witness[color[u]] = u;
+        }
+
+        for (int a = 0; a < k; a++)
+        {
+            if (count[a] != 1)
+                continue;
+            for (int b = 0; b < k; b++)
+            {
+                if (b == a)
+                    continue;
+                std::vector<int> chain = kempeChain(witness[a], a, b);
+                if (chain.empty())
+                    continue;
+                swapChain(chain, a, b);
+                if (!neighborColors(v).contains(a))
+                {
+                    kempeSwaps++;
+                    return a;
+                }
+                swapChain(chain, a, b);
+            }
+        }
+        return -1;
+    }
+
+    int newId(const Segment &s)
+    {
+        int id;
+        if (!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+            segments[id] = s;
+            alive[id] = true;
+        }
+        else
+        {
+            id = segments.size();
+            segments.push_back(s);
+            alive.push_back(true);
+            adj.emplace_back();
+            color.push_back(-1);
+            seen.push_back(0);
+        }
+        return id;
+    }
+
+public:
+    // Starts from a DSatur coloring of the whole instance
+    DynamicColoring(std::vector<Segment> _segments, int threads = 1, int _maxChain = 1000)
+        : segments(std::move(_segments)), alive(segments.size(), true),
+          adj(segments.size()), color(segments.size(), -1),
+          grid(0), seen(segments.size(), 0), maxChain(_maxChain)
+    {
+        DenseGraph g(segments.size(), crossingPairs(segments, BuildMode::Batch, threads));
+        for (int v = 0; v < g.countVertices(); v++)
+            adj[v].assign(g.neighbors(v).begin(), g.neighbors(v).end());
+
+        Coloring start = dsaturColor(g);
+        for (int v = 0; v < (int)segments.size(); v++)
+            setColor(v, start[v]);
+
+        // About sqrt(n) cells along the larger side of the instance
+        i64 minx = LLONG_MAX, maxx = LLONG_MIN, miny = LLONG_MAX, maxy = LLONG_MIN;
+        for (const Segment &s : segments)
+        {
+            for (const Point &p : {s.get_p(), s.get_q()})
+            {
+                minx = std::min(minx, p.x);
+                maxx = std::max(maxx, p.x);
+                miny = std::min(miny, p.y);
+                maxy = std::max(maxy, p.y);
+            }
+        }
+        double side = segments.empty() ? 1 : std::max(maxx - minx, maxy - miny);
+        grid = SegmentGrid(side / std::max(1.0, std::sqrt((double)segments.size())));
+        for (int v = 0; v < (int)segments.size(); v++)
+            grid.insert(v, segments[v]);
+    }
+
+    int insert(const Segment &s)
+    {
+        int v = newId(s);
+
+        seen[v] = ++stamp;
+        grid.forEachCandidate(s, [&](int u) {
+            if (seen[u] != stamp)
+            {
+                seen[u] = stamp;
+                if (segments[u].cross(s))
+                {
+                    adj[v].push_back(u);
+                    adj[u].push_back(v);
+                }
+            }
+        });
+        grid.insert(v, s);
+
+        int c = neighborColors(v).firstAvailable();
+        if (c >= (int)classSize.size())
+        {
+            int freed = kempeRepair(v);
+            if (freed != -1)
+                c = freed;
+            else
+                newColors++;
+        }
+        setColor(v, c);
+        return v;
+    }
+
+    void erase(int v)
+    {
+        grid.erase(v, segments[v]);
+        std::vector<int> neigh = std::move(adj[v]);
+        adj[v].clear();
+        for (int u : neigh)
+        {
+            std::vector<int> &list = adj[u];
+            *std::find(list.begin(), list.end(), v) = list.back();
+            list.pop_back();
+        }
+
+        int freed = color[v];
+        classSize[freed]--;
+        color[v] = -1;
+        alive[v] = false;
+        freeIds.push_back(v);
+
+        // Only the color of v got freed, a former neighbor with a higher
+        // color moves down to it if none of its other neighbors uses it
+        for (int u : neigh)
+        {
+            if (color[u] > freed && std::none_of(adj[u].begin(), adj[u].end(),
+                                                 [&](int w) { return color[w] == freed; }))
+                setColor(u, freed);
+        }
+        shrinkPalette();
+    }
+
+    bool isAlive(int v) const
+    {
+        return v < (int)alive.size() && alive[v];
+    }
+
+    const Segment &segment(int v) const
+    {
+        return segments[v];
+    }
+
+    const std::vector<int> &neighbors(int v) const
+    {
+        return adj[v];
+    }
+
+    const Coloring &coloring() const
+    {
+        return color;
+    }
+
+    // Colors in use
+    int countColors() const
+    {
+        return classSize.size() - std::count(classSize.begin(), classSize.end(), 0);
+    }
+
+    // Ids are reused, so this is an upper bound on alive ids
+    int capacity() const
+    {
+        return segments.size();
+    }
+};
+
+#endif
@@ -4,7 +4,20 @@
 #include "rapidjson/reader.h"
 #include "rapidjson/document.h"
 #include "rapidjson/istreamwrapper.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/filereadstream.h"
 #include "graph.hpp"
+#include "parallel.hpp"
+#include <numeric>
+#include <bit>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 rapidjson::Document read_json(std::string filename)
 {
@@ -34,6 +47,155 @@ std::vector<int> json_int_vec(rapidjson::Value &values) {
   return v;
 }
 
+// Read-only mapping of a whole file
+class MappedFile {
+  int fd = -1;
+  void *ptr = nullptr;
+  size_t len = 0;
+
+public:
+  MappedFile(const std::string &filename) {
+    fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) != 0)
+      return;
+    len = st.st_size;
+    if (len > 0) {
+      ptr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr == MAP_FAILED)
+        ptr = nullptr;
+      else
+        madvise(ptr, len, MADV_SEQUENTIAL);
+    }
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if (ptr)
+      munmap(ptr, len);
+    if (fd != -1)
+      close(fd);
+  }
+
+  bool is_open() const {
+    return fd != -1 && (ptr != nullptr || len == 0);
+  }
+
+  const char *data() const {
+    return (const char *)ptr;
+  }
+
+  size_t size() const {
+    return len;
+  }
+};
+
+// The arrays of a segment instance, as found in the JSON file
+struct SegmentArrays {
+  std::vector<int> x, y, edge_i, edge_j;
+};
+
+// SAX handler pushing the numbers of the x, y, edge_i and edge_j arrays
+// straight into SegmentArrays, reserved from n and m when they come first
+struct SegmentHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, SegmentHandler> {
+  SegmentArrays &out;
+  std::vector<int> *target = nullptr;
+  std::string key;
+  int depth = 0;
+
+  SegmentHandler(SegmentArrays &_out) : out(_out) {
+  }
+
+  bool number(double value) {
+    if (target && depth == 2)
+      target->push_back((int)value);
+    else if (depth == 1 && key == "n") {
+      out.x.reserve(value);
+      out.y.reserve(value);
+    }
+    else if (depth == 1 && key == "m") {
+      out.edge_i.reserve(value);
+      out.edge_j.reserve(value);
+    }
+    return true;
+  }
+
+  bool Int(int i) { return number(i); }
+  bool Uint(unsigned u) { return number(u); }
+  bool Int64(int64_t i) { return number(i); }
+  bool Uint64(uint64_t u) { return number(u); }
+  bool Double(double d) { return number(d); }
+
+  bool Key(const char *str, rapidjson::SizeType length, bool) {
+    if (depth == 1) {
+      key.assign(str, length);
+      target = key == "x" ? &out.x : key == "y" ? &out.y
+             : key == "edge_i" ? &out.edge_i : key == "edge_j" ? &out.edge_j : nullptr;
+    }
+    return true;
+  }
+
+  bool StartObject() { depth++; return true; }
+  bool EndObject(rapidjson::SizeType) { depth--; return true; }
+  bool StartArray() { depth++; return true; }
+  bool EndArray(rapidjson::SizeType) {
+    if (--depth == 1)
+      target = nullptr;
+    return true;
+  }
+};
+
+// Dom parses the whole document first, Stream parses the file through a
+// small buffer and Mapped parses an mmap of the file
+enum class LoadMode { Dom, Stream, Mapped };
+
+SegmentArrays read_arrays(std::string filename, LoadMode mode) {
+  SegmentArrays arrays;
+
+  if (mode == LoadMode::Dom) {
+    rapidjson::Document doc = read_json(filename);
+    arrays.x = json_int_vec(doc["x"]);
+    arrays.y = json_int_vec(doc["y"]);
+    arrays.edge_i = json_int_vec(doc["edge_i"]);
+    arrays.edge_j = json_int_vec(doc["edge_j"]);
+    return arrays;
+  }
+
+  SegmentHandler handler(arrays);
+  rapidjson::Reader reader;
+  rapidjson::ParseResult ok;
+
+  if (mode == LoadMode::Mapped) {
+    MappedFile file(filename);
+    if (!file.is_open()) {
+      std::cerr << "Error reading " << filename << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    rapidjson::MemoryStream ms(file.data(), file.size());
+    ok = reader.Parse(ms, handler);
+  }
+  else {
+    FILE *f = fopen(filename.c_str(), "rb");
+    if (!f) {
+      std::cerr << "Error reading " << filename << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    char buffer[1 << 16];
+    rapidjson::FileReadStream fs(f, buffer, sizeof(buffer));
+    ok = reader.Parse(fs, handler);
+    fclose(f);
+  }
+
+  if (ok.IsError()) {
+    std::cerr << "Error  : " << ok.Code() << std::endl;
+    std::cerr << "Offset : " << ok.Offset() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return arrays;
+}
+
 using i64 = long long int;
 
 class Point {
@@ -175,32 +337,249 @@ public:
   }
 };
 
-Graph<int> readGraph(std::string fn) {
-  rapidjson::Document doc = read_json(fn);
-  Graph<int> g;
+std::vector<Segment> readSegments(std::string fn, LoadMode mode = LoadMode::Mapped) {
+  SegmentArrays arrays = read_arrays(fn, mode);
+  const std::vector<int> &x_vec = arrays.x, &y_vec = arrays.y;
+  const std::vector<int> &i_vec = arrays.edge_i, &j_vec = arrays.edge_j;
 
-  const std::vector<int> x_vec = json_int_vec(doc["x"]);
-  const std::vector<int> y_vec = json_int_vec(doc["y"]);
-  const std::vector<int> i_vec = json_int_vec(doc["edge_i"]);
-  const std::vector<int> j_vec = json_int_vec(doc["edge_j"]);
   std::vector<Segment> segments;
+  segments.reserve(i_vec.size());
   for (size_t k = 0; k < i_vec.size(); k++) {
       Point p(x_vec[i_vec[k]], y_vec[i_vec[k]]);
       Point q(x_vec[j_vec[k]], y_vec[j_vec[k]]);
       segments.push_back(Segment(p, q));
   }
+  return segments;
+}
+
+using CrossingPairs = std::vector<std::pair<int, int>>;
 
+enum class BuildMode { Brute, Sweep, Batch };
+
+// Tests every pair i<j, kept as the reference for the sweep
+CrossingPairs crossingPairsBrute(const std::vector<Segment> &segments) {
+  CrossingPairs pairs;
   int n = segments.size();
 
+  for(int i = 0; i < n; i++)
+    for(int j = i + 1; j < n; j++)
+      if(segments[i].cross(segments[j]))
+        pairs.push_back(std::make_pair(i, j));
+
+  return pairs;
+}
+
+// Segments sorted by their leftmost x, with their coordinates stored as
+// arrays in that order so that a segment can be tested against a batch of
+// consecutive candidates
+struct SweepOrder {
+  const std::vector<Segment> &segments;
+  std::vector<int> index;
+  std::vector<i64> px, py, qx, qy, miny, maxy;
+  bool batchable = true; // Coordinate differences fit in 32 bits
+
+  SweepOrder(const std::vector<Segment> &_segments) : segments(_segments), index(segments.size()) {
+    std::iota(index.begin(), index.end(), 0);
+    // p < q, so p.x is the leftmost x of the segment
+    std::sort(index.begin(), index.end(), [&](int a, int b) {
+      return segments[a].get_p().x < segments[b].get_p().x;
+    });
+
+    const i64 limit = 1LL << 30;
+    for (int i : index) {
+      const Point &p = segments[i].get_p();
+      const Point &q = segments[i].get_q();
+      px.push_back(p.x);
+      py.push_back(p.y);
+      qx.push_back(q.x);
+      qy.push_back(q.y);
+      miny.push_back(std::min(p.y, q.y));
+      maxy.push_back(std::max(p.y, q.y));
+      for (i64 c : {p.x, p.y, q.x, q.y})
+        batchable &= -limit < c && c < limit;
+    }
+  }
+
+  int size() const {
+    return index.size();
+  }
+
+  bool cross(int k, int l) const {
+    return segments[index[k]].cross(segments[index[l]]);
+  }
+
+  // First position after k whose segment starts right of the end of k
+  int overlapEnd(int k) const {
+    return std::upper_bound(px.begin() + k + 1, px.end(), qx[k]) - px.begin();
+  }
+
+  // Calls f(k, l) for every l > k whose bounding box overlaps the one of k
+  template <class F>
+  void forEachOverlap(int k, F f) const {
+    for (int l = k + 1; l < size() && px[l] <= qx[k]; l++)
+      if (miny[l] <= maxy[k] && miny[k] <= maxy[l])
+        f(k, l);
+  }
+
+  // Bit b is set if k crosses l+b, for b < 4. Lanes with a zero
+  // orientation go through the exact Segment::cross.
+  int crossBatchScalar(int k, int l) const {
+    auto sign = [](i64 px, i64 py, i64 qx, i64 qy, i64 rx, i64 ry) {
+      i64 val = (qy - py) * (rx - qx) - (qx - px) * (ry - qy);
+      return (val > 0) - (val < 0);
+    };
+
+    int mask = 0, exact = 0;
+    for (int b = 0; b < 4; b++) {
+      int c = l + b;
+      int o1 = sign(px[k], py[k], qx[k], qy[k], px[c], py[c]);
+      int o2 = sign(px[k], py[k], qx[k], qy[k], qx[c], qy[c]);
+      int o3 = sign(px[c], py[c], qx[c], qy[c], px[k], py[k]);
+      int o4 = sign(px[c], py[c], qx[c], qy[c], qx[k], qy[k]);
+      int zero = (o1 == 0) | (o2 == 0) | (o3 == 0) | (o4 == 0);
+      mask |= ((o1 != o2) & (o3 != o4) & !zero) << b;
+      exact |= zero << b;
+    }
+    return resolveExact(k, l, mask, exact);
+  }
+
+#ifdef __AVX2__
+  // val = (qy-py)*(rx-qx) - (qx-px)*(ry-qy) on 4 lanes. Differences fit
+  // in 32 bits when batchable, so _mm256_mul_epi32 gives exact products.
+  static __m256i orientation(__m256i px, __m256i py, __m256i qx, __m256i qy, __m256i rx, __m256i ry) {
+    __m256i d1 = _mm256_sub_epi64(qy, py);
+    __m256i d2 = _mm256_sub_epi64(rx, qx);
+    __m256i d3 = _mm256_sub_epi64(qx, px);
+    __m256i d4 = _mm256_sub_epi64(ry, qy);
+    return _mm256_sub_epi64(_mm256_mul_epi32(d1, d2), _mm256_mul_epi32(d3, d4));
+  }
+
+  int crossBatch(int k, int l) const {
+    if (!batchable)
+      return crossBatchScalar(k, l);
+
+    auto load = [](const std::vector<i64> &v, int l) {
+      return _mm256_loadu_si256((const __m256i *)(v.data() + l));
+    };
+    __m256i spx = _mm256_set1_epi64x(px[k]), spy = _mm256_set1_epi64x(py[k]);
+    __m256i sqx = _mm256_set1_epi64x(qx[k]), sqy = _mm256_set1_epi64x(qy[k]);
+    __m256i cpx = load(px, l), cpy = load(py, l), cqx = load(qx, l), cqy = load(qy, l);
+
+    __m256i o1 = orientation(spx, spy, sqx, sqy, cpx, cpy);
+    __m256i o2 = orientation(spx, spy, sqx, sqy, cqx, cqy);
+    __m256i o3 = orientation(cpx, cpy, cqx, cqy, spx, spy);
+    __m256i o4 = orientation(cpx, cpy, cqx, cqy, sqx, sqy);
+
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i anyZero = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi64(o1, zero), _mm256_cmpeq_epi64(o2, zero)),
+      _mm256_or_si256(_mm256_cmpeq_epi64(o3, zero), _mm256_cmpeq_epi64(o4, zero)));
+    // With no zero orientation, signs differ iff exactly one is negative
+    __m256i crossing = _mm256_and_si256(
+      _mm256_xor_si256(_mm256_cmpgt_epi64(zero, o1), _mm256_cmpgt_epi64(zero, o2)),
+      _mm256_xor_si256(_mm256_cmpgt_epi64(zero, o3), _mm256_cmpgt_epi64(zero, o4)));
+
+    int exact = _mm256_movemask_pd(_mm256_castsi256_pd(anyZero));
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(crossing)) & ~exact;
+    return resolveExact(k, l, mask, exact);
+  }
+#else
+  int crossBatch(int k, int l) const {
+    return crossBatchScalar(k, l);
+  }
+#endif
+
+  int resolveExact(int k, int l, int mask, int exact) const {
+    for (; exact; exact &= exact - 1) {
+      int b = std::countr_zero((unsigned)exact);
+      if (cross(k, l + b))
+        mask |= 1 << b;
+    }
+    return mask;
+  }
+
+  // Calls f(l) for every l > k crossing k. The batch version skips the
+  // bounding box test and runs the kernel over the whole x-overlap range.
+  template <class F>
+  void forEachCrossing(int k, bool batch, F f) const {
+    if (!batch) {
+      forEachOverlap(k, [&](int, int l) {
+        if (cross(k, l))
+          f(l);
+      });
+      return;
+    }
+
+    int end = overlapEnd(k), l = k + 1;
+    for (; l + 4 <= end; l += 4)
+      for (int mask = crossBatch(k, l); mask; mask &= mask - 1)
+        f(l + std::countr_zero((unsigned)mask));
+    for (; l < end; l++)
+      if (cross(k, l))
+        f(l);
+  }
+};
+
+// Crossing segments share a point, so only pairs whose bounding boxes
+// overlap are tested. Same pairs as crossingPairsBrute, in the same order.
+CrossingPairs crossingPairsSweep(const std::vector<Segment> &segments, bool batch) {
+  SweepOrder order(segments);
+  CrossingPairs pairs;
+
+  for (int k = 0; k < order.size(); k++)
+    order.forEachCrossing(k, batch, [&](int l) {
+      pairs.push_back(std::minmax(order.index[k], order.index[l]));
+    });
+
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+
+// Same sweep, each worker takes blocks of the sweep order and fills its own
+// buffer. Buffers are sorted and merged so the result does not depend on
+// the scheduling.
+CrossingPairs crossingPairsParallel(const std::vector<Segment> &segments, bool batch, int threads) {
+  const int blockSize = 64;
+  SweepOrder order(segments);
+  ThreadPool pool(threads);
+  std::vector<CrossingPairs> buffers(pool.size());
+
+  int blocks = (order.size() + blockSize - 1) / blockSize;
+  pool.run(blocks, [&](int t, int b) {
+    int end = std::min(order.size(), (b + 1) * blockSize);
+    for (int k = b * blockSize; k < end; k++)
+      order.forEachCrossing(k, batch, [&](int l) {
+        buffers[t].push_back(std::minmax(order.index[k], order.index[l]));
+      });
+  });
+
+  return mergeSorted(pool, buffers);
+}
+
+CrossingPairs crossingPairs(const std::vector<Segment> &segments, BuildMode mode, int threads = 1) {
+  if (mode == BuildMode::Brute)
+    return crossingPairsBrute(segments);
+  bool batch = mode == BuildMode::Batch;
+  if (threads > 1)
+    return crossingPairsParallel(segments, batch, threads);
+  return crossingPairsSweep(segments, batch);
+}
+
+Graph<int> buildGraph(int n, const CrossingPairs &pairs) {
+  Graph<int> g;
+
   for(int i = 0; i < n; i++)
     g.addVertex(i);
 
-  for(int i = 0; i < segments.size(); i++)
-    for(int j = 0; j < segments.size(); j++)
-      if(segments[i].cross(segments[j]))
-        g.addEdge(i,j);
+  for (const auto &[i, j] : pairs)
+    g.addEdge(i, j);
 
   return g;
 }
 
+Graph<int> readGraph(std::string fn, BuildMode mode = BuildMode::Batch, int threads = 1) {
+  std::vector<Segment> segments = readSegments(fn);
+  return buildGraph(segments.size(), crossingPairs(segments, mode, threads));
+}
+
 #endif
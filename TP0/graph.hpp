@@ -9,6 +9,8 @@
 #include <vector>
 #include <queue>
 #include <cassert>
+#include <span>
+#include <utility>
 
 template <class Vertex>
 class Graph
@@ -132,10 +134,109 @@ public:
         return ret;
     }
 
-    std::unordered_set<Vertex> neighbors(Vertex v) const
+    const std::unordered_set<Vertex> &neighbors(Vertex v) const
     {
         return adj.at(v);
     }
 };
 
+// Immutable graph on vertices 0..n-1 with sorted neighbor arrays
+class DenseGraph
+{
+    std::vector<int> offsets;
+    std::vector<int> targets;
+
+public:
+    DenseGraph() : offsets(1, 0) {}
+
+    // Every edge is given once, in any direction
+    DenseGraph(int n, const std::vector<std::pair<int, int>> &edges) : offsets(n + 1, 0)
+    {
+        for (const auto &[u, v] : edges)
+        {
+            offsets[u + 1]++;
+            offsets[v + 1]++;
+        }
+        for (int v = 0; v < n; v++)
+            offsets[v + 1] += offsets[v];
+
+        targets.resize(offsets[n]);
+        std::vector<int> next(offsets.begin(), offsets.end() - 1);
+        for (const auto &[u, v] : edges)
+        {
+            targets[next[u]++] = v;
+            targets[next[v]++] = u;
+        }
+        for (int v = 0; v < n; v++)
+            std::sort(targets.begin() + offsets[v], targets.begin() + offsets[v + 1]);
+    }
+
+    // The vertices of g must be 0..n-1
+    DenseGraph(const Graph<int> &g) : DenseGraph(g.countVertices(), g.edges())
+    {
+    }
+
+    // Takes arrays already in CSR form, neighbors of v being
+    // targets[offsets[v]..offsets[v+1]) sorted
+    DenseGraph(std::vector<int> _offsets, std::vector<int> _targets)
+        : offsets(std::move(_offsets)), targets(std::move(_targets))
+    {
+    }
+
+    const std::vector<int> &csrOffsets() const
+    {
+        return offsets;
+    }
+
+    const std::vector<int> &csrTargets() const
+    {
+        return targets;
+    }
+
+    int countVertices() const
+    {
+        return offsets.size() - 1;
+    }
+
+    long countEdges() const
+    {
+        return targets.size() / 2;
+    }
+
+    int degree(int v) const
+    {
+        return offsets[v + 1] - offsets[v];
+    }
+
+    int maxDegree() const
+    {
+        int ret = -1;
+        for (int v = 0; v < countVertices(); v++)
+            ret = std::max(ret, degree(v));
+        return ret;
+    }
+
+    bool containsEdge(int u, int v) const
+    {
+        std::span<const int> neigh = neighbors(u);
+        return std::binary_search(neigh.begin(), neigh.end(), v);
+    }
+
+    // Every edge once, as (u, v) with u < v
+    std::vector<std::pair<int, int>> edges() const
+    {
+        std::vector<std::pair<int, int>> ret;
+        for (int v = 0; v < countVertices(); v++)
+            for (int u : neighbors(v))
+                if (u < v)
+                    ret.push_back(std::make_pair(u, v));
+        return ret;
+    }
+
+    std::span<const int> neighbors(int v) const
+    {
+        return {targets.data() + offsets[v], targets.data() + offsets[v + 1]};
+    }
+};
+
 #endif
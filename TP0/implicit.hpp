@@ -0,0 +1,137 @@
+#ifndef IMPLICIT_HPP
+#define IMPLICIT_HPP
+
+#include <vector>
+#include <climits>
+#include "files.hpp"
+#include "parallel.hpp"
+
+// Max of the right ends over ranges of the sweep order. Finds the
+// segments before k whose x extent reaches the left end of k without
+// scanning all of them.
+class ExtentTree
+{
+    int leaves = 1;
+    std::vector<i64> tree;
+
+    template <class F>
+    void collect(int node, int lo, int hi, int end, i64 x, F &f) const
+    {
+        if (lo >= end || tree[node] < x)
+            return;
+        if (hi - lo == 1)
+        {
+            f(lo);
+            return;
+        }
+        int mid = (lo + hi) / 2;
+        collect(2 * node, lo, mid, end, x, f);
+        collect(2 * node + 1, mid, hi, end, x, f);
+    }
+
+public:
+    ExtentTree(const std::vector<i64> &right)
+    {
+        while (leaves < (int)right.size())
+            leaves *= 2;
+        tree.assign(2 * leaves, LLONG_MIN);
+        std::copy(right.begin(), right.end(), tree.begin() + leaves);
+        for (int node = leaves - 1; node > 0; node--)
+            tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+    }
+
+    // Calls f(l) for every l < end with right[l] >= x
+    template <class F>
+    void forEachReaching(int end, i64 x, F f) const
+    {
+        collect(1, 0, leaves, end, x, f);
+    }
+};
+
+// Crossing graph that is never stored: neighbors are recomputed from the
+// segments on every query, degrees are counted once. Memory stays linear
+// in the number of segments, each neighbors() call costs a sweep query.
+class ImplicitGraph
+{
+    std::vector<Segment> segments;
+    SweepOrder order;
+    ExtentTree extents;
+    std::vector<int> position; // Position of each segment in the sweep order
+    std::vector<int> degrees;
+
+public:
+    ImplicitGraph(std::vector<Segment> _segments, int threads = 1)
+        : segments(std::move(_segments)), order(segments), extents(order.qx),
+          position(segments.size()), degrees(segments.size(), 0)
+    {
+        for (int k = 0; k < order.size(); k++)
+            position[order.index[k]] = k;
+
+        // Counting pass, each worker counts into its own array
+        const int blockSize = 64;
+        ThreadPool pool(threads);
+        std::vector<std::vector<int>> counts(pool.size(), std::vector<int>(order.size(), 0));
+        pool.run((order.size() + blockSize - 1) / blockSize, [&](int t, int b) {
+            int end = std::min(order.size(), (b + 1) * blockSize);
+            for (int k = b * blockSize; k < end; k++)
+                order.forEachCrossing(k, true, [&](int l) {
+                    counts[t][order.index[k]]++;
+                    counts[t][order.index[l]]++;
+                });
+        });
+        for (const std::vector<int> &count : counts)
+            for (int v = 0; v < order.size(); v++)
+                degrees[v] += count[v];
+    }
+
+    // order refers to segments
+    ImplicitGraph(const ImplicitGraph &) = delete;
+    ImplicitGraph &operator=(const ImplicitGraph &) = delete;
+
+    int countVertices() const
+    {
+        return segments.size();
+    }
+
+    long countEdges() const
+    {
+        long ret = 0;
+        for (int d : degrees)
+            ret += d;
+        return ret / 2;
+    }
+
+    int degree(int v) const
+    {
+        return degrees[v];
+    }
+
+    int maxDegree() const
+    {
+        int ret = -1;
+        for (int d : degrees)
+            ret = std::max(ret, d);
+        return ret;
+    }
+
+    // Segments after v in the sweep order come from the forward sweep,
+    // the ones before from the extent tree
+    std::vector<int> neighbors(int v) const
+    {
+        std::vector<int> ret;
+        ret.reserve(degrees[v]);
+        int k = position[v];
+
+        order.forEachCrossing(k, true, [&](int l) {
+            ret.push_back(order.index[l]);
+        });
+        extents.forEachReaching(k, order.px[k], [&](int l) {
+            if (order.miny[l] <= order.maxy[k] && order.miny[k] <= order.maxy[l] && order.cross(l, k))
+                ret.push_back(order.index[l]);
+        });
+
+        return ret;
+    }
+};
+
+#endif
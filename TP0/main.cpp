@@ -2,8 +2,17 @@
 
 #include <iostream>
 #include <cassert>
+#include <chrono>
 #include "graph.hpp"
 #include "files.hpp"
+#include "coloring.hpp"
+#include "tabucol.hpp"
+#include "cache.hpp"
+#include "implicit.hpp"
+#include "clique.hpp"
+#include "ordering.hpp"
+#include "peel.hpp"
+#include <sys/resource.h>
 
 int firstAvailableColor(const std::unordered_set<int>& colorSet)
 {
@@ -18,12 +27,13 @@ std::unordered_map<int, int> greedyColor(const Graph<int>& g)
     int maxColor = -1;
 
     std::unordered_map<int, int> color;
-    std::unordered_set<int> vertices = g.vertices();
+    // Vertices of g are 0..n-1
+    PeelGraph todo(g.countVertices(), [&](int v) -> const std::unordered_set<int>& { return g.neighbors(v); });
 
-    while (todo.countVertices())
+    while (!todo.empty())
     {
         int v = todo.maxDegreeVertex();
-        todo.removeVertex(v);
+        todo.remove(v);
 
         std::unordered_set<int> neighborColors;
 
@@ -63,19 +73,259 @@ void testColor(const Graph<int>& g, std::unordered_map<int, int>& color)
     std::cout << "Coloring verified!" << std::endl;
 }
 
-int main(int argc, char **argv)
+template <class G>
+void testColor(const G& g, const Coloring& color)
 {
-    if (argc != 2)
+    for (int v = 0; v < g.countVertices(); v++)
     {
-        std::cout << "./main filename.instance.json" << std::endl;
-        return 1;
+        if (color[v] < 0)
+        {
+            std::cout << "Uncolored vertex " << v << std::endl;
+            exit(1);
+        }
+
+        for (int u : g.neighbors(v))
+        {
+            if (color[u] == color[v])
+            {
+                std::cout << "Same color: " << u << " " << v << std::endl;
+                exit(1);
+            }
+        }
     }
+    std::cout << "Coloring verified!" << std::endl;
+}
+
+// Checks that the sweep builds exactly the brute force edge set
+bool checkBuild(const std::string &fn, int threads)
+{
+    std::vector<Segment> segments = readSegments(fn);
+    CrossingPairs brute = crossingPairs(segments, BuildMode::Brute);
+    CrossingPairs sweep = crossingPairs(segments, BuildMode::Sweep);
+    CrossingPairs batch = crossingPairs(segments, BuildMode::Batch);
+    CrossingPairs parallel = crossingPairs(segments, BuildMode::Batch, threads);
+
+    std::cout << "Brute force edges: " << brute.size() << std::endl;
+    std::cout << "Sweep edges: " << sweep.size() << std::endl;
+    std::cout << "Batch sweep edges: " << batch.size() << std::endl;
+    std::cout << "Parallel batch sweep edges (" << threads << " threads): " << parallel.size() << std::endl;
+    return brute == sweep && sweep == batch && batch == parallel;
+}
 
-    Graph<int> g = readGraph(argv[1]);
+enum class Order { Degree, DSatur, Parallel, Portfolio };
+
+template <class G>
+Coloring colorGraph(const G& g, Order order, int threads)
+{
     std::cout << "Graph vertices: " << g.countVertices() << std::endl;
     std::cout << "Graph edges: " << g.countEdges() << std::endl;
-    std::unordered_map<int, int> color = greedyColor(g);
+
+    Coloring color;
+    if (order == Order::DSatur)
+        color = dsaturColor(g);
+
+    if (order == Order::Parallel)
+    {
+        ThreadPool pool(threads);
+        SpeculativeStats stats;
+        color = speculativeColor(g, pool, stats);
+        std::cout << "Speculative coloring on " << pool.size() << " threads: "
+                  << stats.conflicts.size() << " rounds in " << stats.seconds << "s, conflicts per round:";
+        for (int conflicts : stats.conflicts)
+            std::cout << " " << conflicts;
+        std::cout << std::endl;
+    }
+
+    std::cout << "Number of colors: " << countColors(color) << std::endl;
     testColor(g, color);
+    return color;
+}
+
+bool testClique(const DenseGraph& g, const std::vector<int>& clique)
+{
+    for (size_t i = 0; i < clique.size(); i++)
+        for (size_t j = i + 1; j < clique.size(); j++)
+            if (!g.containsEdge(clique[i], clique[j]))
+                return false;
+    return true;
+}
+
+double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+long peakMemoryKB()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "./main filename.instance.json [--build=brute|sweep|batch] [--threads=N] [--order=degree|dsatur|parallel|portfolio] [--tabu=SECONDS] [--clique=SECONDS] [--no-cache] [--implicit] [--check-build]" << std::endl;
+        return 1;
+    }
+
+    BuildMode mode = BuildMode::Batch;
+    int threads = defaultThreads();
+    Order order = Order::DSatur;
+    double tabuTime = 0;
+    double cliqueTime = 1;
+    bool useCache = true;
+    bool implicit = false;
+    bool check = false;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--build=brute")
+            mode = BuildMode::Brute;
+        else if (arg == "--build=sweep")
+            mode = BuildMode::Sweep;
+        else if (arg == "--build=batch")
+            mode = BuildMode::Batch;
+        else if (arg.starts_with("--threads="))
+            threads = std::stoi(arg.substr(10));
+        else if (arg == "--order=degree")
+            order = Order::Degree;
+        else if (arg == "--order=dsatur")
+            order = Order::DSatur;
+        else if (arg == "--order=parallel")
+            order = Order::Parallel;
+        else if (arg == "--order=portfolio")
+            order = Order::Portfolio;
+        else if (arg.starts_with("--tabu="))
+            tabuTime = std::stod(arg.substr(7));
+        else if (arg.starts_with("--clique="))
+            cliqueTime = std::stod(arg.substr(9));
+        else if (arg == "--no-cache")
+            useCache = false;
+        else if (arg == "--implicit")
+            implicit = true;
+        else if (arg == "--check-build")
+            check = true;
+        else
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (check)
+    {
+        bool same = checkBuild(argv[1], std::max(threads, 2));
+        std::cout << (same ? "Same edge set" : "Edge sets differ!") << std::endl;
+        return same ? 0 : 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (implicit)
+    {
+        if (order == Order::Degree || order == Order::Portfolio || tabuTime > 0)
+        {
+            std::cout << "Implicit mode only runs --order=dsatur|parallel" << std::endl;
+            return 1;
+        }
+        ImplicitGraph g(readSegments(argv[1]), threads);
+        std::cout << "Counted degrees in " << seconds(start) << "s" << std::endl;
+        colorGraph(g, order, threads);
+        std::cout << "Total " << seconds(start) << "s, peak memory " << peakMemoryKB() / 1024 << "MB" << std::endl;
+        return 0;
+    }
+
+    uint64_t hash = useCache ? hashFile(argv[1]) : 0;
+    std::optional<DenseGraph> cached;
+    if (useCache)
+        cached = loadCachedGraph(argv[1], hash);
+
+    DenseGraph g;
+    if (cached)
+    {
+        g = std::move(*cached);
+        std::cout << "Loaded " << cacheFilename(argv[1]);
+    }
+    else
+    {
+        std::vector<Segment> segments = readSegments(argv[1]);
+        g = DenseGraph(segments.size(), crossingPairs(segments, mode, threads));
+        std::cout << "Built graph";
+        if (useCache && saveCachedGraph(argv[1], hash, g))
+            std::cout << ", saved to " << cacheFilename(argv[1]);
+    }
+    std::cout << " in " << seconds(start) << "s" << std::endl;
+
+    // Lower bound, nothing left to gain once the coloring reaches it
+    int bound = 1;
+    if (cliqueTime > 0)
+    {
+        auto cliqueStart = std::chrono::steady_clock::now();
+        std::vector<int> clique = CliqueFinder(g).run(cliqueTime);
+        if (!testClique(g, clique))
+        {
+            std::cout << "Not a clique!" << std::endl;
+            exit(1);
+        }
+        bound = std::max<int>(bound, clique.size());
+        std::cout << "Clique of size " << clique.size() << " found in " << seconds(cliqueStart) << "s" << std::endl;
+    }
+
+    Coloring color(g.countVertices(), -1);
+    if (order == Order::Degree)
+    {
+        Graph<int> h = buildGraph(g.countVertices(), g.edges());
+        std::cout << "Graph vertices: " << h.countVertices() << std::endl;
+        std::cout << "Graph edges: " << h.countEdges() << std::endl;
+        std::unordered_map<int, int> greedy = greedyColor(h);
+        testColor(h, greedy);
+        for (const auto &[v, c] : greedy)
+            color[v] = c;
+    }
+    else if (order == Order::Portfolio)
+    {
+        std::vector<PortfolioResult> results;
+        int best = orderingPortfolio(g, bound, results);
+        for (const PortfolioResult &result : results)
+        {
+            std::cout << result.name << ": ";
+            if (result.color.empty())
+                std::cout << "stopped";
+            else
+                std::cout << countColors(result.color) << " colors";
+            std::cout << " in " << result.seconds << "s" << std::endl;
+        }
+        if (best == -1)
+        {
+            // Empty graph, or every result stopped or rejected
+            std::cout << "No portfolio result, falling back to DSatur" << std::endl;
+            color = colorGraph(g, Order::DSatur, threads);
+        }
+        else
+        {
+            color = results[best].color;
+            std::cout << "Number of colors: " << countColors(color) << " (" << results[best].name << ")" << std::endl;
+            testColor(g, color);
+        }
+    }
+    else
+        color = colorGraph(g, order, threads);
+
+    if (tabuTime > 0 && countColors(color) > bound)
+    {
+        color = TabuCol(g, color).reduce(tabuTime, bound);
+        std::cout << "Number of colors after TabuCol: " << countColors(color) << std::endl;
+        testColor(g, color);
+    }
+
+    if (cliqueTime > 0)
+    {
+        int gap = countColors(color) - bound;
+        std::cout << "Colors " << countColors(color) << ", clique " << bound << ", gap " << gap
+                  << (gap == 0 ? " (optimal)" : "") << std::endl;
+    }
 
+    std::cout << "Total " << seconds(start) << "s, peak memory " << peakMemoryKB() / 1024 << "MB" << std::endl;
     return 0;
 }
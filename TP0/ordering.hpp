@@ -0,0 +1,234 @@
+#ifndef ORDERING_HPP
+#define ORDERING_HPP
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include "graph.hpp"
+#include "coloring.hpp"
+
+// First fit in the given order
+Coloring greedyOrderColor(const DenseGraph &g, const std::vector<int> &order)
+{
+    int n = g.countVertices();
+    Coloring color(n, -1);
+    std::vector<int> forbidden(std::max(0, g.maxDegree()) + 2, -1);
+
+    for (int v : order)
+    {
+        for (int u : g.neighbors(v))
+            if (color[u] >= 0)
+                forbidden[color[u]] = v;
+        int c = 0;
+        while (forbidden[c] == v)
+            c++;
+        color[v] = c;
+    }
+    return color;
+}
+
+std::vector<int> largestFirstOrder(const DenseGraph &g)
+{
+    std::vector<int> order(g.countVertices());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int u, int v) {
+        return g.degree(u) > g.degree(v);
+    });
+    return order;
+}
+
+// Repeatedly removes a vertex of minimum degree in the remaining graph and
+// colors in reverse removal order. Vertices sit in doubly linked lists, one
+// per current degree, so the whole ordering is O(V+E).
+std::vector<int> smallestLastOrder(const DenseGraph &g)
+{
+    int n = g.countVertices();
+    int maxDeg = std::max(0, g.maxDegree());
+    std::vector<int> head(maxDeg + 1, -1), next(n, -1), prev(n, -1), deg(n);
+    std::vector<bool> removed(n, false);
+
+    auto unlink = [&](int v) {
+        if (prev[v] != -1)
+            next[prev[v]] = next[v];
+        else
+            head[deg[v]] = next[v];
+        if (next[v] != -1)
+            prev[next[v]] = prev[v];
+    };
+    auto link = [&](int v) {
+        prev[v] = -1;
+        next[v] = head[deg[v]];
+        if (next[v] != -1)
+            prev[next[v]] = v;
+        head[deg[v]] = v;
+    };
+
+    for (int v = 0; v < n; v++)
+    {
+        deg[v] = g.degree(v);
+        link(v);
+    }
+
+    std::vector<int> order(n);
+    int low = 0;
+    for (int i = n - 1; i >= 0; i--)
+    {
+        // A removal lowers degrees by one, so the minimum drops by at most one
+        low = std::max(0, low - 1);
+        while (head[low] == -1)
+            low++;
+        int v = head[low];
+        unlink(v);
+        removed[v] = true;
+        order[i] = v;
+        for (int u : g.neighbors(v))
+        {
+            if (!removed[u])
+            {
+                unlink(u);
+                deg[u]--;
+                link(u);
+            }
+        }
+    }
+    return order;
+}
+
+// Recursive Largest First: builds one color class at a time. The class
+// starts with the uncolored vertex of largest uncolored degree, then keeps
+// adding the candidate with the most neighbors among the excluded vertices
+// W. Candidates are a bitset and counts into W are kept incrementally, but
+// each pick rescans the candidate bits, so a class costs O(V*|class| + E).
+// Returns an empty coloring if stop is raised.
+Coloring rlfColor(const DenseGraph &g, const std::atomic<bool> &stop)
+{
+    int n = g.countVertices();
+    int words = (n + 63) / 64;
+    Coloring color(n, -1);
+    std::vector<uint64_t> candidates(words);
+    std::vector<int> degU(n), countW(n);
+    for (int v = 0; v < n; v++)
+        degU[v] = g.degree(v);
+
+    auto has = [&](int v) { return candidates[v / 64] >> (v % 64) & 1; };
+    auto drop = [&](int v) { candidates[v / 64] &= ~(uint64_t(1) << (v % 64)); };
+
+    int uncolored = n;
+    for (int c = 0; uncolored > 0; c++)
+    {
+        if (stop)
+            return {};
+
+        std::fill(countW.begin(), countW.end(), 0);
+        for (int v = 0; v < n; v++)
+            if (color[v] == -1)
+                candidates[v / 64] |= uint64_t(1) << (v % 64);
+
+        // Best candidate, by count into W then fewest candidate neighbors
+        auto pick = [&]() {
+            int best = -1;
+            for (int w = 0; w < words; w++)
+            {
+                for (uint64_t bits = candidates[w]; bits; bits &= bits - 1)
+                {
+                    int x = w * 64 + std::countr_zero(bits);
+                    if (best == -1 || countW[x] > countW[best]
+                        || (countW[x] == countW[best] && degU[x] - countW[x] < degU[best] - countW[best]))
+                        best = x;
+                }
+            }
+            return best;
+        };
+
+        int x = -1;
+        for (int w = 0; w < words; w++)
+            for (uint64_t bits = candidates[w]; bits; bits &= bits - 1)
+                if (int v = w * 64 + std::countr_zero(bits); x == -1 || degU[v] > degU[x])
+                    x = v;
+
+        for (; x != -1; x = pick())
+        {
+            color[x] = c;
+            uncolored--;
+            drop(x);
+            for (int y : g.neighbors(x))
+            {
+                degU[y]--;
+                if (has(y))
+                {
+                    drop(y);
+                    for (int z : g.neighbors(y))
+                        countW[z]++;
+                }
+            }
+        }
+    }
+    return color;
+}
+
+bool isValidColoring(const DenseGraph &g, const Coloring &color)
+{
+    for (int v = 0; v < g.countVertices(); v++)
+    {
+        if (color[v] < 0)
+            return false;
+        for (int u : g.neighbors(v))
+            if (color[u] == color[v])
+                return false;
+    }
+    return true;
+}
+
+struct PortfolioResult
+{
+    std::string name;
+    Coloring color; // Empty if stopped early
+    double seconds = 0;
+};
+
+// Runs every ordering on its own thread. Once one reaches the lower bound
+// the others are told to stop. Returns the index of the best valid result.
+int orderingPortfolio(const DenseGraph &g, int bound, std::vector<PortfolioResult> &results)
+{
+    std::atomic<bool> stop = false;
+    std::vector<std::pair<std::string, std::function<Coloring()>>> strategies = {
+        {"largest first", [&] { return greedyOrderColor(g, largestFirstOrder(g)); }},
+        {"smallest last", [&] { return greedyOrderColor(g, smallestLastOrder(g)); }},
+        {"DSatur", [&] { return dsaturColor(g); }},
+        {"RLF", [&] { return rlfColor(g, stop); }},
+    };
+
+    results.assign(strategies.size(), {});
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < strategies.size(); i++)
+    {
+        threads.emplace_back([&, i] {
+            auto start = std::chrono::steady_clock::now();
+            results[i].name = strategies[i].first;
+            results[i].color = strategies[i].second();
+            results[i].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!results[i].color.empty() && !isValidColoring(g, results[i].color))
+                results[i].color.clear();
+            if (!results[i].color.empty() && countColors(results[i].color) <= bound)
+                stop = true;
+        });
+    }
+    for (std::thread &t : threads)
+        t.join();
+
+    int best = -1;
+    for (size_t i = 0; i < results.size(); i++)
+        if (!results[i].color.empty()
+            && (best == -1 || countColors(results[i].color) < countColors(results[best].color)))
+            best = i;
+    return best;
+}
+
+#endif
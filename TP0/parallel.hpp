@@ -0,0 +1,122 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+int defaultThreads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Fixed set of workers running one job at a time, split in blocks
+class ThreadPool
+{
+    std::vector<std::thread> workers;
+    std::mutex m;
+    std::condition_variable wake, done;
+
+    std::function<void(int, int)> job;
+    std::atomic<int> next;
+    int blocks = 0;
+    int active = 0;
+    long generation = 0;
+    bool stop = false;
+
+    void work(int id)
+    {
+        long seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(m);
+                wake.wait(lock, [&] { return stop || generation != seen; });
+                if (stop)
+                    return;
+                seen = generation;
+            }
+
+            for (int b = next++; b < blocks; b = next++)
+                job(id, b);
+
+            std::lock_guard lock(m);
+            if (--active == 0)
+                done.notify_one();
+        }
+    }
+
+public:
+    ThreadPool(int threads = defaultThreads()) : next(0)
+    {
+        for (int id = 0; id < std::max(1, threads); id++)
+            workers.emplace_back(&ThreadPool::work, this, id);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        for (std::thread &t : workers)
+            t.join();
+    }
+
+    int size() const
+    {
+        return workers.size();
+    }
+
+    // Calls f(thread, block) for every block in [0, count), blocks are
+    // handed out on demand so uneven blocks still balance
+    void run(int count, std::function<void(int, int)> f)
+    {
+        if (count <= 0)
+            return;
+        std::unique_lock lock(m);
+        job = std::move(f);
+        blocks = count;
+        next = 0;
+        active = size();
+        generation++;
+        wake.notify_all();
+        done.wait(lock, [&] { return active == 0; });
+    }
+};
+
+// Sorts then merges per thread buffers into one sorted vector
+template <class T>
+std::vector<T> mergeSorted(ThreadPool &pool, std::vector<std::vector<T>> &buffers)
+{
+    pool.run(buffers.size(), [&](int, int b) {
+        std::sort(buffers[b].begin(), buffers[b].end());
+    });
+
+    while (buffers.size() > 1)
+    {
+        std::vector<std::vector<T>> merged((buffers.size() + 1) / 2);
+        pool.run(merged.size(), [&](int, int b) {
+            if (2 * b + 1 == (int)buffers.size())
+            {
+                merged[b] = std::move(buffers[2 * b]);
+                return;
+            }
+            std::vector<T> &x = buffers[2 * b], &y = buffers[2 * b + 1];
+            merged[b].resize(x.size() + y.size());
+            std::merge(x.begin(), x.end(), y.begin(), y.end(), merged[b].begin());
+            std::vector<T>().swap(x);
+            std::vector<T>().swap(y);
+        });
+        buffers = std::move(merged);
+    }
+
+    return buffers.empty() ? std::vector<T>() : std::move(buffers[0]);
+}
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef TABUCOL_HPP
+#define TABUCOL_HPP
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "graph.hpp"
+#include "coloring.hpp"
+
+// Starting from a valid coloring, repeatedly drops one color class and
+// repairs the coloring with TabuCol. gamma[v][c] counts the neighbors of v
+// colored c, so a move is evaluated in O(1) and applied in O(deg).
+class TabuCol
+{
+    const DenseGraph &g;
+    int n, k, stride;
+    Coloring color;
+    std::vector<int> gamma;
+    std::vector<long> tabu; // Iteration until which moving v to c is tabu
+    std::vector<int> conflicting, position;
+    long conflicts = 0; // Edges with both ends of the same color
+    long iterations = 0;
+    std::mt19937 rng;
+
+    int &gammaAt(int v, int c)
+    {
+        return gamma[(size_t)v * stride + c];
+    }
+
+    void updateConflicting(int v)
+    {
+        bool inConflict = gammaAt(v, color[v]) > 0;
+        if (inConflict && position[v] == -1)
+        {
+            position[v] = conflicting.size();
+            conflicting.push_back(v);
+        }
+        else if (!inConflict && position[v] != -1)
+        {
+            int last = conflicting.back();
+            conflicting[position[v]] = last;
+            position[last] = position[v];
+            conflicting.pop_back();
+            position[v] = -1;
+        }
+    }
+
+    void move(int v, int c)
+    {
+        int old = color[v];
+        conflicts += gammaAt(v, c) - gammaAt(v, old);
+        color[v] = c;
+        for (int u : g.neighbors(v))
+        {
+            gammaAt(u, old)--;
+            gammaAt(u, c)++;
+            updateConflicting(u);
+        }
+        updateConflicting(v);
+    }
+
+    // Moves the smallest class to the least conflicting colors, then gives
+    // its label to color k-1
+    void removeColor()
+    {
+        std::vector<int> size(k, 0);
+        for (int c : color)
+            size[c]++;
+        int removed = std::min_element(size.begin(), size.end()) - size.begin();
+
+        for (int v = 0; v < n; v++)
+        {
+            if (color[v] != removed)
+                continue;
+            int best = -1;
+            for (int c = 0; c < k; c++)
+                if (c != removed && (best == -1 || gammaAt(v, c) < gammaAt(v, best)))
+                    best = c;
+            move(v, best);
+        }
+
+        int last = k - 1;
+        for (int v = 0; v < n; v++)
+        {
+            std::swap(gammaAt(v, removed), gammaAt(v, last));
+            if (color[v] == last)
+                color[v] = removed;
+        }
+        std::fill(tabu.begin(), tabu.end(), 0);
+        k--;
+    }
+
+    // One tabu step: best non tabu move of a conflicting vertex, or a tabu
+    // one if it beats the best count seen at this k
+    void step(long bestConflicts)
+    {
+        int bestV = -1, bestC = -1, bestDelta = 0, ties = 0;
+        for (int v : conflicting)
+        {
+            int own = gammaAt(v, color[v]);
+            for (int c = 0; c < k; c++)
+            {
+                if (c == color[v])
+                    continue;
+                int delta = gammaAt(v, c) - own;
+                bool allowed = tabu[(size_t)v * stride + c] <= iterations || conflicts + delta < bestConflicts;
+                if (!allowed || (bestV != -1 && delta > bestDelta))
+                    continue;
+                if (bestV == -1 || delta < bestDelta)
+                {
+                    ties = 0;
+                    bestDelta = delta;
+                }
+                if (std::uniform_int_distribution<int>(0, ties++)(rng) == 0)
+                {
+                    bestV = v;
+                    bestC = c;
+                }
+            }
+        }
+
+        iterations++;
+        if (bestV == -1)
+            return;
+
+        int old = color[bestV];
+        move(bestV, bestC);
+        long tenure = 0.6 * conflicting.size() + std::uniform_int_distribution<int>(0, 9)(rng);
+        tabu[(size_t)bestV * stride + old] = iterations + tenure;
+    }
+
+public:
+    TabuCol(const DenseGraph &_g, const Coloring &start, unsigned seed = 1)
+        : g(_g), n(g.countVertices()), k(countColors(start)), stride(std::max(k, 1)),
+          color(start), gamma((size_t)n * stride, 0), tabu((size_t)n * stride, 0),
+          position(n, -1), rng(seed)
+    {
+        for (int v = 0; v < n; v++)
+            for (int u : g.neighbors(v))
+                gammaAt(v, color[u])++;
+    }
+
+    // Best valid coloring found before the time budget runs out, stops
+    // early once it uses target colors
+    Coloring reduce(double seconds, int target = 1)
+    {
+        using Clock = std::chrono::steady_clock;
+        auto deadline = Clock::now() + std::chrono::duration<double>(seconds);
+        auto start = Clock::now();
+        Coloring best = color;
+
+        while (k > std::max(target, 1) && Clock::now() < deadline)
+        {
+            removeColor();
+            long bestConflicts = conflicts;
+            while (conflicts > 0 && (iterations % 256 != 0 || Clock::now() < deadline))
+            {
+                step(bestConflicts);
+                bestConflicts = std::min(bestConflicts, conflicts);
+            }
+
+            if (conflicts > 0)
+                break;
+
+            best = color;
+            std::cout << "TabuCol: " << k << " colors after " << iterations << " iterations ("
+                      << std::chrono::duration<double>(Clock::now() - start).count() << "s)" << std::endl;
+        }
+
+        return best;
+    }
+};
+
+#endif
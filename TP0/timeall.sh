@@ -4,7 +4,7 @@ TIMEFORMAT=%Rs
 for opt in -Ofast -O3 -O2 -O1 -O0
 do
   echo Optimization: $opt
-  g++ main.cpp -std=c++20 -Wfatal-errors -o main $opt
+  g++ main.cpp -std=c++20 -pthread -Wfatal-errors -o main $opt -march=native
   for f in `ls -Sr input/*.json`
   do
     echo -n $f" "
@@ -8,6 +8,12 @@
 #include <tuple>
 #include <functional>
 #include <numeric>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include "FlatHash.hpp"
+#include "SpscQueue.hpp"
 
 namespace std
 {
@@ -16,19 +22,18 @@ namespace std
     {
         std::size_t operator()(const std::tuple<int, int> &t) const
         {
-            auto h1 = std::hash<int>{}(std::get<0>(t));
-            auto h2 = std::hash<int>{}(std::get<1>(t));
-            return h1 ^ (h2 << 1);
+            return hashCombine(mixHash(std::get<0>(t)), std::get<1>(t));
         }
     };
 }
-#include "rapidjson/document.h"
-#include "rapidjson/istreamwrapper.h"
+#include "rapidjson/reader.h"
+#include "rapidjson/filereadstream.h"
 
 template <class Number>
 struct Point
 {
     Number x, y;
+    Point() : x(0), y(0) {}
     Point(Number _x, Number _y) : x(_x), y(_y) {}
     double distance(Point<Number> p) const
     {
@@ -44,6 +49,73 @@ struct Point
     }
 };
 
+// SAX handler for instance files: hands points over in batches, as soon
+// as they are parsed, instead of building the whole document first
+template <class Number>
+class InstanceHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, InstanceHandler<Number>>
+{
+    static constexpr size_t BatchSize = 4096;
+
+    SpscQueue<std::vector<Point<Number>>> &queue;
+    std::vector<Point<Number>> batch;
+    Point<Number> point;
+    std::string top, key;
+    int depth = 0;
+
+public:
+    Number radius = 0;
+
+    InstanceHandler(SpscQueue<std::vector<Point<Number>>> &_queue) : queue(_queue) {}
+
+    bool StartObject()
+    {
+        depth++;
+        return true;
+    }
+
+    bool EndObject(rapidjson::SizeType)
+    {
+        if (depth == 2 && top == "points")
+        {
+            batch.push_back(point);
+            if (batch.size() == BatchSize)
+                flush();
+        }
+        depth--;
+        return true;
+    }
+
+    bool Key(const char *str, rapidjson::SizeType length, bool)
+    {
+        (depth == 1 ? top : key).assign(str, length);
+        return true;
+    }
+
+    bool Double(double d)
+    {
+        if (depth == 1 && top == "radius")
+            radius = d;
+        else if (depth == 2 && top == "points" && key == "x")
+            point.x = d;
+        else if (depth == 2 && top == "points" && key == "y")
+            point.y = d;
+        return true;
+    }
+
+    bool Int(int i) { return Double(i); }
+    bool Uint(unsigned u) { return Double(u); }
+    bool Int64(int64_t i) { return Double(i); }
+    bool Uint64(uint64_t u) { return Double(u); }
+
+    void flush()
+    {
+        if (!batch.empty())
+            queue.push(std::move(batch));
+        batch = {};
+        batch.reserve(BatchSize);
+    }
+};
+
 template <class Number>
 class Solver
 {
@@ -54,10 +126,8 @@ class Solver
 
     struct CellHash {
         size_t operator()(const Cell& c) const noexcept {
-            // Usual mix
-            size_t h1 = std::hash<long long>{}(c.x);
-            size_t h2 = std::hash<long long>{}(c.y);
-            return h1 ^ (h2 << 1);
+            // x ^ (y << 1) would send whole diagonals to few slots
+            return hashCombine(mixHash(c.x), c.y);
         }
     };
 
@@ -71,28 +141,48 @@ class Solver
     }
 
 public:
+    // This thread parses the file while another one appends the batches
+    // of points to pts, through a bounded queue : O(n)
     Solver(std::string fn)
     {
-        // Open file : O(1)
-        std::ifstream in(fn, std::ifstream::in | std::ifstream::binary);
-        rapidjson::IStreamWrapper isw{in};
-        rapidjson::Document doc{};
-        doc.ParseStream(isw);
-
-        // Load points in a vector : O(n)
-        const rapidjson::Value &jspoints = doc["points"];
-        for (auto &jspoint : jspoints.GetArray())
-        {
-            Number x = jspoint["x"].GetDouble();
-            Number y = jspoint["y"].GetDouble();
-            pts.push_back(Point<Number>{x, y});
-        }
+        auto since = [](auto start) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+        auto start = std::chrono::steady_clock::now();
+
+        FILE *in = fopen(fn.c_str(), "rb");
+        if (!in)
+            throw std::runtime_error("Could not open instance file: " + fn);
+
+        SpscQueue<std::vector<Point<Number>>> queue(16);
+        double build = 0;
+        std::thread builder([&]() {
+            while (auto batch = queue.pop())
+            {
+                auto begin = std::chrono::steady_clock::now();
+                pts.insert(pts.end(), batch->begin(), batch->end());
+                build += since(begin);
+            }
+        });
+
+        char buffer[1 << 16];
+        rapidjson::FileReadStream stream(in, buffer, sizeof(buffer));
+        InstanceHandler<Number> handler(queue);
+        rapidjson::Reader reader;
+        rapidjson::ParseResult ok = reader.Parse(stream, handler);
+        handler.flush();
+        queue.close();
+        double parse = since(start);
+        builder.join();
+        fclose(in);
+        if (!ok)
+            throw std::runtime_error("Malformed instance file: " + fn);
 
-        // Load radius value : O(1)
-        radius = doc["radius"].GetDouble();
+        radius = handler.radius;
         std::cout << "Read " << pts.size()
                   << " points with radius " << radius
-                  << "." << std::endl;
+                  << " in " << since(start) << "s (parse " << parse
+                  << "s, build " << build << "s)." << std::endl;
     }
 
     std::vector<Point<Number>> greedy(Point<Number> dir)
@@ -111,7 +201,7 @@ public:
 
         // Instantiate a grid of indexes of point
         const Number cellSize = Number(2) * radius;
-        std::unordered_map<Cell, std::vector<int>, CellHash> grid;
+        FlatMap<Cell, std::vector<int>, CellHash> grid;
         
         // Match each point with a cell on a grid
         int ptsSize = (int) pts.size();
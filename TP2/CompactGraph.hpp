@@ -0,0 +1,527 @@
+#ifndef COMPACT_GRAPH_HPP
+#define COMPACT_GRAPH_HPP
+
+#include <algorithm>
+#include <vector>
+#include <span>
+#include <utility>
+#include <tuple>
+#include <memory>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <iterator>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "EdgeReader.hpp"
+
+// Layout of a .gbin snapshot: this header, then each array at its byte
+// offset, 64-byte aligned, in native little-endian order. Offsets of
+// absent arrays are 0.
+struct GraphFileHeader {
+  static constexpr char Magic[4] = {'G', 'B', 'I', 'N'};
+  static constexpr uint32_t Version = 1;
+
+  char magic[4];
+  uint32_t version;
+  uint32_t vertexBytes, indexBytes;
+  uint64_t vertices, arcs;
+  // ids[vertices], offsets[vertices + 1], targets[arcs], then optional
+  // byId[vertices] and coordinates[2 * vertices]
+  uint64_t idsAt, offsetsAt, targetsAt, byIdAt, coordinatesAt;
+};
+
+// Whether filename is a snapshot rather than an .edges list
+inline bool isGraphFile(const std::string &filename) {
+  char magic[4] = {};
+  std::ifstream(filename, std::ios::binary).read(magic, 4);
+  return std::memcmp(magic, GraphFileHeader::Magic, 4) == 0;
+}
+
+// Immutable graph in CSR form. Vertices are dense indices 0..n-1 given in
+// increasing order of their original ids, so id() maps back for output and
+// index() is a binary search. Neighbor lists are sorted and contiguous.
+// permute() renumbers the indices for locality, index() then searches
+// through byId instead.
+// The arrays are read through spans, over vectors of the graph or over a
+// mapped snapshot that copies share.
+template<class Vertex>
+class CompactGraph {
+public:
+  using Index = uint32_t;
+
+private:
+  std::vector<Vertex> ownIds;
+  std::vector<uint64_t> ownOffsets{0};
+  std::vector<Index> ownTargets, ownById;
+  std::vector<uint32_t> ownCoordinates;
+  std::shared_ptr<const MappedFile> file;
+
+  std::span<const Vertex> ids;
+  std::span<const uint64_t> offsets;
+  std::span<const Index> targets;
+  // Indices by increasing id, empty while ids is sorted
+  std::span<const Index> byId;
+  // x and y of each vertex, empty when unknown
+  std::span<const uint32_t> coords;
+
+  // Points the spans at the vectors, after any change to them
+  void bind() {
+    ids = ownIds;
+    offsets = ownOffsets;
+    targets = ownTargets;
+    byId = ownById;
+    coords = ownCoordinates;
+  }
+
+  void indexIds() {
+    bind();
+    ownById.clear();
+    if(!std::is_sorted(ids.begin(), ids.end())) {
+      ownById.resize(ids.size());
+      for(Index u = 0; u < ownById.size(); u++)
+        ownById[u] = u;
+      std::sort(ownById.begin(), ownById.end(), [&](Index a, Index b) { return ids[a] < ids[b]; });
+    }
+    bind();
+  }
+
+  // Position of v among the ids in increasing order
+  size_t rank(Vertex v) const {
+    if(byId.empty())
+      return std::lower_bound(ids.begin(), ids.end(), v) - ids.begin();
+    return std::lower_bound(byId.begin(), byId.end(), v, [&](Index u, Vertex w) { return ids[u] < w; }) - byId.begin();
+  }
+
+  // Arcs given as dense indices, in any order. They are placed by source
+  // in O(E), then each row is sorted and deduplicated on its own, rows
+  // split across threads.
+  void build(Index n, const std::vector<std::pair<Index, Index>> &arcs, int threads = 1) {
+    std::vector<uint64_t> &off = ownOffsets;
+    std::vector<Index> &tgt = ownTargets;
+    off.assign(n + 1, 0);
+    for(const auto &[u, v] : arcs)
+      off[u + 1]++;
+    for(Index u = 0; u < n; u++)
+      off[u + 1] += off[u];
+
+    tgt.resize(arcs.size());
+    std::vector<uint64_t> next(off.begin(), off.end() - 1);
+    for(const auto &[u, v] : arcs)
+      tgt[next[u]++] = v;
+
+    std::vector<uint64_t> length(n);
+    parallelFor(threads, [&](int t) {
+      for(Index u = (uint64_t) n * t / threads; u < (uint64_t) n * (t + 1) / threads; u++) {
+        auto first = tgt.begin() + off[u], last = tgt.begin() + off[u + 1];
+        std::sort(first, last);
+        length[u] = std::unique(first, last) - first;
+      }
+    });
+
+    uint64_t out = 0;
+    for(Index u = 0; u < n; u++) {
+      if(out != off[u])
+        std::copy(tgt.begin() + off[u], tgt.begin() + off[u] + length[u], tgt.begin() + out);
+      off[u] = out;
+      out += length[u];
+    }
+    off[n] = out;
+    tgt.resize(out);
+    tgt.shrink_to_fit();
+    bind();
+  }
+
+  // Dense index of every endpoint, in parallel
+  std::vector<std::pair<Index, Index>> remap(const std::vector<std::pair<Vertex, Vertex>> &raw, int threads) const {
+    std::vector<std::pair<Index, Index>> edges(raw.size());
+    parallelFor(threads, [&](int t) {
+      for(size_t i = raw.size() * t / threads; i < raw.size() * (t + 1) / threads; i++)
+        edges[i] = {index(raw[i].first), index(raw[i].second)};
+    });
+    return edges;
+  }
+
+  // count elements of type T at byte offset at of the mapping
+  template<class T>
+  std::span<const T> section(uint64_t at, uint64_t count, const std::string &filename) const {
+    if(at % alignof(T) != 0 || at > file->size() || count > (file->size() - at) / sizeof(T))
+      throw std::runtime_error("Truncated graph file: " + filename);
+    return {(const T *) (file->data() + at), (size_t) count};
+  }
+
+public:
+  CompactGraph() {
+    bind();
+  }
+
+  // Mapped copies share the mapping, others get their own arrays
+  CompactGraph(const CompactGraph &other) {
+    *this = other;
+  }
+
+  CompactGraph &operator=(const CompactGraph &other) {
+    ownIds = other.ownIds;
+    ownOffsets = other.ownOffsets;
+    ownTargets = other.ownTargets;
+    ownById = other.ownById;
+    ownCoordinates = other.ownCoordinates;
+    file = other.file;
+    ids = other.ids;
+    offsets = other.offsets;
+    targets = other.targets;
+    byId = other.byId;
+    coords = other.coords;
+    if(!file)
+      bind();
+    else if(!ownCoordinates.empty())
+      coords = ownCoordinates;
+    return *this;
+  }
+
+  // Moved vectors keep their buffers, and so the spans stay valid
+  CompactGraph(CompactGraph &&) = default;
+  CompactGraph &operator=(CompactGraph &&) = default;
+
+  // Same format and rules as Graph(filename), or a snapshot from save()
+  CompactGraph(std::string filename, int threads = readerThreads()) {
+    if(isGraphFile(filename))
+      *this = map(filename);
+    else
+      *this = CompactGraph(readEdgeList<Vertex>(filename, threads), threads);
+  }
+
+  // Edges between original ids, self-loops ignored
+  CompactGraph(const std::vector<std::pair<Vertex, Vertex>> &raw, int threads = readerThreads()) {
+    ownIds.resize(2 * raw.size());
+    for(size_t i = 0; i < raw.size(); i++) {
+      ownIds[2 * i] = raw[i].first;
+      ownIds[2 * i + 1] = raw[i].second;
+    }
+    parallelSort(ownIds, threads);
+    ownIds.erase(std::unique(ownIds.begin(), ownIds.end()), ownIds.end());
+    ownIds.shrink_to_fit();
+    bind();
+
+    std::vector<std::pair<Index, Index>> arcs = remap(raw, threads);
+    std::erase_if(arcs, [](const auto &e) { return e.first == e.second; });
+    size_t m = arcs.size();
+    arcs.resize(2 * m);
+    for(size_t i = 0; i < m; i++)
+      arcs[m + i] = {arcs[i].second, arcs[i].first};
+    build(ids.size(), arcs, threads);
+  }
+
+  // Any graph with vertices() and neighbors()
+  template<class G>
+  static CompactGraph from(const G &g) {
+    CompactGraph ret;
+    std::vector<std::pair<Vertex, Vertex>> raw;
+    for(Vertex v : g.vertices()) {
+      ret.ownIds.push_back(v);
+      for(Vertex u : g.neighbors(v))
+        raw.emplace_back(v, u);
+    }
+    std::sort(ret.ownIds.begin(), ret.ownIds.end());
+    ret.bind();
+
+    ret.build(ret.ids.size(), ret.remap(raw, 1));
+    return ret;
+  }
+
+  // Serves a snapshot straight from its mapping, without copying it, and
+  // processes mapping the same file share its pages. Offsets and targets
+  // are checked in one linear pass.
+  static CompactGraph map(const std::string &filename) {
+    static_assert(std::is_integral_v<Vertex>, "Snapshots hold integer ids");
+    CompactGraph ret;
+    ret.file = std::make_shared<const MappedFile>(filename, MADV_RANDOM);
+    GraphFileHeader h;
+    if(ret.file->size() < sizeof(h))
+      throw std::runtime_error("Truncated graph file: " + filename);
+    std::memcpy(&h, ret.file->data(), sizeof(h));
+    if(std::memcmp(h.magic, GraphFileHeader::Magic, 4) != 0 || h.version != GraphFileHeader::Version
+       || h.vertexBytes != sizeof(Vertex) || h.indexBytes != sizeof(Index))
+      throw std::runtime_error("Unsupported graph file: " + filename);
+
+    ret.ids = ret.section<Vertex>(h.idsAt, h.vertices, filename);
+    ret.offsets = ret.section<uint64_t>(h.offsetsAt, h.vertices + 1, filename);
+    ret.targets = ret.section<Index>(h.targetsAt, h.arcs, filename);
+    if(h.byIdAt != 0)
+      ret.byId = ret.section<Index>(h.byIdAt, h.vertices, filename);
+    if(h.coordinatesAt != 0)
+      ret.coords = ret.section<uint32_t>(h.coordinatesAt, 2 * h.vertices, filename);
+    // One pass over the arrays, so that no later access leaves them
+    bool ok = ret.offsets[0] == 0 && ret.offsets[h.vertices] == h.arcs;
+    for(uint64_t u = 0; ok && u < h.vertices; u++)
+      ok = ret.offsets[u] <= ret.offsets[u + 1];
+    for(uint64_t i = 0; ok && i < h.arcs; i++)
+      ok = ret.targets[i] < h.vertices;
+    for(uint64_t i = 0; ok && i < ret.byId.size(); i++)
+      ok = ret.byId[i] < h.vertices;
+    if(!ok)
+      throw std::runtime_error("Malformed graph file: " + filename);
+    return ret;
+  }
+
+  // Writes the snapshot map() reads, to a temporary file renamed over
+  // filename, so that a graph mapped from filename itself stays valid
+  void save(const std::string &filename) const {
+    GraphFileHeader h{};
+    std::memcpy(h.magic, GraphFileHeader::Magic, 4);
+    h.version = GraphFileHeader::Version;
+    h.vertexBytes = sizeof(Vertex);
+    h.indexBytes = sizeof(Index);
+    h.vertices = countVertices();
+    h.arcs = targets.size();
+
+    uint64_t end = sizeof(h);
+    auto place = [&](size_t bytes) {
+      uint64_t at = (end + 63) / 64 * 64;
+      end = at + bytes;
+      return at;
+    };
+    h.idsAt = place(ids.size_bytes());
+    h.offsetsAt = place(offsets.size_bytes());
+    h.targetsAt = place(targets.size_bytes());
+    h.byIdAt = byId.empty() ? 0 : place(byId.size_bytes());
+    h.coordinatesAt = coords.empty() ? 0 : place(coords.size_bytes());
+
+    std::string tmp = filename + ".tmp";
+    std::ofstream out(tmp, std::ios::binary);
+    uint64_t written = 0;
+    auto write = [&](uint64_t at, const void *data, size_t bytes) {
+      static const char zeros[64] = {};
+      out.write(zeros, at - written);
+      out.write((const char *) data, bytes);
+      written = at + bytes;
+    };
+    write(0, &h, sizeof(h));
+    write(h.idsAt, ids.data(), ids.size_bytes());
+    write(h.offsetsAt, offsets.data(), offsets.size_bytes());
+    write(h.targetsAt, targets.data(), targets.size_bytes());
+    if(h.byIdAt != 0)
+      write(h.byIdAt, byId.data(), byId.size_bytes());
+    if(h.coordinatesAt != 0)
+      write(h.coordinatesAt, coords.data(), coords.size_bytes());
+    out.close();
+    if(!out || std::rename(tmp.c_str(), filename.c_str()) != 0) {
+      std::remove(tmp.c_str());
+      throw std::runtime_error("Could not write graph file: " + filename);
+    }
+  }
+
+  // Whether the arrays live in a mapped snapshot
+  bool mapped() const {
+    return file != nullptr;
+  }
+
+  bool hasCoordinates() const {
+    return !coords.empty();
+  }
+
+  std::pair<uint32_t, uint32_t> coordinates(Index u) const {
+    return {coords[2 * u], coords[2 * u + 1]};
+  }
+
+  // Coordinates of each vertex as f(id) gives them, kept by save()
+  template<class F>
+  void setCoordinates(F f) {
+    ownCoordinates.resize(2 * countVertices());
+    for(Index u = 0; u < countVertices(); u++)
+      std::tie(ownCoordinates[2 * u], ownCoordinates[2 * u + 1]) = f(id(u));
+    coords = ownCoordinates;
+  }
+
+  Index countVertices() const {
+    return ids.size();
+  }
+
+  uint64_t countEdges() const {
+    return targets.size() / 2;
+  }
+
+  bool containsVertex(Vertex v) const {
+    size_t r = rank(v);
+    return r < ids.size() && id(byId.empty() ? r : byId[r]) == v;
+  }
+
+  // Dense index of an original id, which must be in the graph
+  Index index(Vertex v) const {
+    size_t r = rank(v);
+    return byId.empty() ? r : byId[r];
+  }
+
+  // Original id of a dense index
+  Vertex id(Index u) const {
+    return ids[u];
+  }
+
+  int degree(Index u) const {
+    return offsets[u + 1] - offsets[u];
+  }
+
+  int maxDegree() const {
+    int ret = -1;
+    for(Index u = 0; u < countVertices(); u++)
+      ret = std::max(ret, degree(u));
+    return ret;
+  }
+
+  std::span<const Index> neighbors(Index u) const {
+    return targets.subspan(offsets[u], offsets[u + 1] - offsets[u]);
+  }
+
+  bool containsEdge(Index u, Index v) const {
+    std::span<const Index> neigh = neighbors(u);
+    return std::binary_search(neigh.begin(), neigh.end(), v);
+  }
+
+  // Each edge u < v once, sorted since the rows are
+  class EdgeIterator {
+    const CompactGraph *g = nullptr;
+    Index u = 0;
+    uint64_t k = 0;
+
+    // First neighbor of u above u, or the next row with one
+    void settle() {
+      while(u < g->countVertices()) {
+        std::span<const Index> neigh = g->neighbors(u);
+        k = std::upper_bound(neigh.begin(), neigh.end(), u) - neigh.begin() + g->offsets[u];
+        if(k < g->offsets[u + 1])
+          return;
+        u++;
+      }
+      k = 0;
+    }
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::pair<Index, Index>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::pair<Index, Index>;
+
+    EdgeIterator() {
+    }
+
+    EdgeIterator(const CompactGraph *_g, Index _u) : g(_g), u(_u) {
+      settle();
+    }
+
+    std::pair<Index, Index> operator*() const {
+      return {u, g->targets[k]};
+    }
+
+    EdgeIterator &operator++() {
+      if(++k == g->offsets[u + 1]) {
+        u++;
+        settle();
+      }
+      return *this;
+    }
+
+    EdgeIterator operator++(int) {
+      EdgeIterator ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    bool operator==(const EdgeIterator &other) const {
+      return u == other.u && k == other.k;
+    }
+  };
+
+  struct EdgeRange {
+    EdgeIterator first, last;
+
+    EdgeIterator begin() const { return first; }
+    EdgeIterator end() const { return last; }
+  };
+
+  EdgeRange edges() const {
+    return {EdgeIterator(this, 0), EdgeIterator(this, countVertices())};
+  }
+
+  std::vector<Index> bfs(Index v, int maxv = 0) const {
+    std::vector<bool> visited(countVertices(), false);
+    std::vector<Index> ret;
+
+    if(maxv == 0)
+      maxv = countVertices();
+
+    // ret doubles as the queue, visited is set when a vertex is queued
+    ret.push_back(v);
+    visited[v] = true;
+    for(size_t i = 0; i < ret.size() && ret.size() < (size_t) maxv; i++) {
+      for(Index w : neighbors(ret[i])) {
+        if(!visited[w]) {
+          visited[w] = true;
+          ret.push_back(w);
+        }
+      }
+    }
+    if(ret.size() > (size_t) maxv)
+      ret.resize(maxv);
+
+    return ret;
+  }
+
+  // Induced subgraph, with its own dense indices but the same ids
+  CompactGraph subGraph(std::vector<Index> vertices) const {
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+    CompactGraph ret;
+    std::vector<std::pair<Index, Index>> arcs;
+    for(Index i = 0; i < vertices.size(); i++) {
+      ret.ownIds.push_back(ids[vertices[i]]);
+      for(Index w : neighbors(vertices[i])) {
+        auto it = std::lower_bound(vertices.begin(), vertices.end(), w);
+        if(it != vertices.end() && *it == w)
+          arcs.emplace_back(i, it - vertices.begin());
+      }
+    }
+    ret.build(vertices.size(), arcs);
+    ret.indexIds();
+    return ret;
+  }
+
+  // Same graph where index i is the old order[i], order being a
+  // permutation of 0..n-1
+  CompactGraph permute(std::span<const Index> order) const {
+    std::vector<Index> position(countVertices());
+    for(Index i = 0; i < countVertices(); i++)
+      position[order[i]] = i;
+
+    CompactGraph ret;
+    ret.ownIds.resize(countVertices());
+    ret.ownOffsets.resize(countVertices() + 1);
+    ret.ownTargets.resize(targets.size());
+    for(Index i = 0; i < countVertices(); i++) {
+      ret.ownIds[i] = ids[order[i]];
+      ret.ownOffsets[i + 1] = ret.ownOffsets[i] + degree(order[i]);
+      auto out = ret.ownTargets.begin() + ret.ownOffsets[i];
+      for(Index w : neighbors(order[i]))
+        *out++ = position[w];
+      std::sort(ret.ownTargets.begin() + ret.ownOffsets[i], out);
+    }
+    if(hasCoordinates()) {
+      ret.ownCoordinates.resize(coords.size());
+      for(Index i = 0; i < countVertices(); i++)
+        std::tie(ret.ownCoordinates[2 * i], ret.ownCoordinates[2 * i + 1]) = coordinates(order[i]);
+    }
+    ret.indexIds();
+    return ret;
+  }
+
+  // Bytes of the arrays, mapped or not
+  size_t memoryBytes() const {
+    return ids.size_bytes() + offsets.size_bytes() + targets.size_bytes() + byId.size_bytes() + coords.size_bytes();
+  }
+};
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef EDGE_READER_HPP
+#define EDGE_READER_HPP
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <charconv>
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SpscQueue.hpp"
+
+inline int readerThreads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls f(t) for t in 0..threads-1, each on its own thread
+template<class F>
+void parallelFor(int threads, F f) {
+  if(threads <= 1) {
+    f(0);
+    return;
+  }
+  std::vector<std::thread> pool;
+  for(int t = 0; t < threads; t++)
+    pool.emplace_back(f, t);
+  for(std::thread &th : pool)
+    th.join();
+}
+
+// Sorts chunks in parallel, then merges neighboring runs two by two
+template<class T>
+void parallelSort(std::vector<T> &v, int threads = readerThreads()) {
+  threads = std::max<int>(1, std::min<size_t>(threads, v.size() / 4096 + 1));
+  std::vector<size_t> cuts(threads + 1);
+  for(int t = 0; t <= threads; t++)
+    cuts[t] = v.size() * t / threads;
+
+  parallelFor(threads, [&](int t) {
+    std::sort(v.begin() + cuts[t], v.begin() + cuts[t + 1]);
+  });
+  for(int width = 1; width < threads; width *= 2) {
+    int merges = (threads + 2 * width - 1) / (2 * width);
+    parallelFor(merges, [&](int i) {
+      int lo = 2 * width * i, mid = std::min(lo + width, threads), hi = std::min(lo + 2 * width, threads);
+      std::inplace_merge(v.begin() + cuts[lo], v.begin() + cuts[mid], v.begin() + cuts[hi]);
+    });
+  }
+}
+
+// Read-only mapping of a whole file. Pages come from the page cache,
+// shared by every process that maps the same file.
+class MappedFile {
+  const char *ptr = nullptr;
+  size_t length = 0;
+
+public:
+  MappedFile(const std::string &filename, int advice = MADV_NORMAL) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw std::runtime_error("Could not open graph file: " + filename);
+    struct stat st;
+    length = fstat(fd, &st) == 0 ? st.st_size : 0;
+    if(length > 0) {
+      void *p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+      if(p == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Could not open graph file: " + filename);
+      }
+      madvise(p, length, advice);
+      ptr = (const char *) p;
+    }
+    close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if(length > 0)
+      munmap((void *) ptr, length);
+  }
+
+  const char *data() const {
+    return ptr;
+  }
+
+  size_t size() const {
+    return length;
+  }
+};
+
+// Parses "u v" lines between begin and end. Blank lines are skipped,
+// self-loops dropped. Returns false on any other line.
+template<class Vertex>
+bool parseEdges(const char *p, const char *end, std::vector<std::pair<Vertex, Vertex>> &out) {
+  auto blank = [&]() {
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+      p++;
+  };
+
+  while(p < end) {
+    blank();
+    if(p < end && *p == '\n') {
+      p++;
+      continue;
+    }
+    if(p == end)
+      break;
+
+    Vertex u, v;
+    auto [pu, eu] = std::from_chars(p, end, u);
+    if(eu != std::errc())
+      return false;
+    p = pu;
+    blank();
+    auto [pv, ev] = std::from_chars(p, end, v);
+    if(ev != std::errc())
+      return false;
+    p = pv;
+    blank();
+    if(p < end) {
+      if(*p != '\n')
+        return false;
+      p++;
+    }
+
+    if(u != v)
+      out.emplace_back(u, v);
+  }
+  return true;
+}
+
+// Reads an .edges file. The file is mapped, cut into chunks that start
+// right after a newline, and each chunk is parsed on its own thread.
+template<class Vertex>
+std::vector<std::pair<Vertex, Vertex>> readEdgeList(const std::string &filename, int threads = readerThreads()) {
+  MappedFile file(filename, MADV_SEQUENTIAL);
+  const char *data = file.data();
+  size_t size = file.size();
+
+  threads = std::max<int>(1, std::min<size_t>(threads, size / (1 << 20) + 1));
+  std::vector<size_t> cuts(threads + 1, size);
+  cuts[0] = 0;
+  for(int t = 1; t < threads; t++) {
+    size_t pos = std::max(cuts[t - 1], size * t / threads);
+    while(pos < size && data[pos - 1] != '\n')
+      pos++;
+    cuts[t] = pos;
+  }
+
+  std::vector<std::vector<std::pair<Vertex, Vertex>>> parts(threads);
+  std::vector<char> ok(threads, true);
+  parallelFor(threads, [&](int t) {
+    parts[t].reserve((cuts[t + 1] - cuts[t]) / 12);
+    ok[t] = parseEdges(data + cuts[t], data + cuts[t + 1], parts[t]);
+  });
+  if(std::find(ok.begin(), ok.end(), false) != ok.end())
+    throw std::runtime_error("Malformed line in graph file: " + filename);
+
+  if(threads == 1)
+    return std::move(parts[0]);
+  size_t total = 0;
+  for(const auto &part : parts)
+    total += part.size();
+  std::vector<std::pair<Vertex, Vertex>> ret;
+  ret.reserve(total);
+  for(const auto &part : parts)
+    ret.insert(ret.end(), part.begin(), part.end());
+  return ret;
+}
+
+// Seconds each stage of a pipelined load spent working, and end to end
+struct LoadTimes {
+  double parse = 0, build = 0, total = 0;
+};
+
+// Pipelined reading of an .edges file: this thread parses the mapped file
+// a chunk at a time while `builders` threads run build(b, edges) on each
+// parsed chunk, b in 0..builders-1. Every builder sees every chunk, in
+// file order, through its own bounded queue, and keeps the edges it owns.
+// build is the slowest builder, without its waits.
+template<class Vertex, class F>
+LoadTimes pipelineEdges(const std::string &filename, int builders, F build) {
+  using Chunk = std::shared_ptr<const std::vector<std::pair<Vertex, Vertex>>>;
+  constexpr size_t ChunkBytes = 1 << 20;
+  auto since = [](auto start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+  auto start = std::chrono::steady_clock::now();
+
+  MappedFile file(filename, MADV_SEQUENTIAL);
+  std::vector<std::unique_ptr<SpscQueue<Chunk>>> queues;
+  for(int b = 0; b < builders; b++)
+    queues.push_back(std::make_unique<SpscQueue<Chunk>>(16));
+
+  LoadTimes ret;
+  std::vector<double> busy(builders, 0);
+  std::vector<std::thread> pool;
+  for(int b = 0; b < builders; b++) {
+    pool.emplace_back([&, b]() {
+      while(std::optional<Chunk> chunk = queues[b]->pop()) {
+        auto begin = std::chrono::steady_clock::now();
+        build(b, **chunk);
+        busy[b] += since(begin);
+      }
+    });
+  }
+
+  bool ok = true;
+  const char *p = file.data(), *end = p + file.size();
+  while(ok && p < end) {
+    auto begin = std::chrono::steady_clock::now();
+    const char *cut = p + std::min<size_t>(ChunkBytes, end - p);
+    while(cut < end && cut[-1] != '\n')
+      cut++;
+    auto chunk = std::make_shared<std::vector<std::pair<Vertex, Vertex>>>();
+    chunk->reserve((cut - p) / 12);
+    ok = parseEdges(p, cut, *chunk);
+    p = cut;
+    ret.parse += since(begin);
+    for(auto &queue : queues)
+      queue->push(chunk);
+  }
+  for(auto &queue : queues)
+    queue->close();
+  for(std::thread &th : pool)
+    th.join();
+  if(!ok)
+    throw std::runtime_error("Malformed line in graph file: " + filename);
+
+  ret.build = *std::max_element(busy.begin(), busy.end());
+  ret.total = since(start);
+  return ret;
+}
+
+// Both directions of every edge, sorted with duplicates removed
+template<class Vertex>
+std::vector<std::pair<Vertex, Vertex>> symmetricArcs(std::vector<std::pair<Vertex, Vertex>> edges,
+                                                     int threads = readerThreads()) {
+  size_t m = edges.size();
+  edges.resize(2 * m);
+  for(size_t i = 0; i < m; i++)
+    edges[m + i] = {edges[i].second, edges[i].first};
+  parallelSort(edges, threads);
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  return edges;
+}
+
+#endif
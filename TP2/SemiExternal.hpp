@@ -0,0 +1,294 @@
+#ifndef SEMI_EXTERNAL_HPP
+#define SEMI_EXTERNAL_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include "EdgeReader.hpp"
+#include "FlatHash.hpp"
+
+// Maximal independent set of an .edges file larger than memory. Only
+// per-vertex arrays stay in RAM: sorted ids, degrees and states, plus a
+// few more during improve(). Each pass reads the whole file again from
+// disk, front to back, through one fixed buffer.
+template<class Vertex>
+class SemiExternalMIS {
+public:
+  using Index = uint32_t;
+
+private:
+  enum State : uint8_t { Undecided, In, Out };
+  static constexpr Index None = Index(-1);
+  static constexpr size_t BlockBytes = 8 << 20;
+
+  std::string filename;
+  std::vector<Vertex> ids;
+  std::vector<uint32_t> deg;
+  std::vector<uint8_t> state;
+  uint64_t edges = 0, bytes = 0;
+  int passes = 0;
+
+  // Calls f(u, v) on each edge of the file, in file order
+  template<class F>
+  void scan(F f) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw std::runtime_error("Could not open graph file: " + filename);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    passes++;
+
+    std::vector<char> buffer(BlockBytes);
+    std::vector<std::pair<Vertex, Vertex>> chunk;
+    size_t kept = 0;
+    for(;;) {
+      ssize_t got = read(fd, buffer.data() + kept, buffer.size() - kept);
+      if(got < 0) {
+        close(fd);
+        throw std::runtime_error("Could not read graph file: " + filename);
+      }
+      bytes += got;
+      size_t size = kept + got, cut = size;
+      // The partial last line waits for the next block, unless the file ended
+      if(got > 0) {
+        while(cut > 0 && buffer[cut - 1] != '\n')
+          cut--;
+        if(cut == 0) {
+          kept = size;
+          if(kept == buffer.size())
+            buffer.resize(2 * buffer.size());
+          continue;
+        }
+      }
+
+      chunk.clear();
+      if(!parseEdges(buffer.data(), buffer.data() + cut, chunk)) {
+        close(fd);
+        throw std::runtime_error("Malformed line in graph file: " + filename);
+      }
+      for(auto [u, v] : chunk)
+        f(u, v);
+
+      kept = size - cut;
+      std::memmove(buffer.data(), buffer.data() + cut, kept);
+      if(got == 0)
+        break;
+    }
+    close(fd);
+  }
+
+  // Same on dense indices
+  template<class F>
+  void scanIndices(F f) {
+    scan([&](Vertex u, Vertex v) { f(index(u), index(v)); });
+  }
+
+  // Keeps ids sorted and distinct
+  void compact() {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  }
+
+  // Greedy order: increasing degree, ties broken by hashed id so that
+  // chains of equal degrees stay short
+  bool before(Index u, Index v) const {
+    if(deg[u] != deg[v])
+      return deg[u] < deg[v];
+    uint64_t hu = mixHash(ids[u]), hv = mixHash(ids[v]);
+    return hu != hv ? hu < hv : u < v;
+  }
+
+  // Decides every undecided vertex. Each round is one pass: undecided
+  // neighbors of In vertices leave, and an undecided vertex is blocked by
+  // any undecided neighbor before it. Unblocked ones then join. The set is
+  // the one sequential greedy builds in that order, and the first undecided
+  // vertex always joins, so every round makes progress.
+  void complete() {
+    std::vector<bool> blocked(ids.size());
+    while(std::find(state.begin(), state.end(), Undecided) != state.end()) {
+      std::fill(blocked.begin(), blocked.end(), false);
+      scanIndices([&](Index u, Index v) {
+        if(state[u] == In && state[v] == Undecided)
+          state[v] = Out;
+        else if(state[v] == In && state[u] == Undecided)
+          state[u] = Out;
+        else if(state[u] == Undecided && state[v] == Undecided)
+          blocked[before(u, v) ? v : u] = true;
+      });
+      for(Index u = 0; u < ids.size(); u++)
+        if(state[u] == Undecided && !blocked[u])
+          state[u] = In;
+    }
+  }
+
+public:
+  // Two passes: one collects the ids, the next counts degrees
+  explicit SemiExternalMIS(const std::string &_filename) : filename(_filename) {
+    size_t limit = 1 << 20;
+    scan([&](Vertex u, Vertex v) {
+      ids.push_back(u);
+      ids.push_back(v);
+      if(ids.size() >= limit) {
+        compact();
+        limit = std::max(limit, 2 * ids.size());
+      }
+    });
+    compact();
+    ids.shrink_to_fit();
+    if(ids.size() >= None)
+      throw std::runtime_error("Too many vertices in graph file: " + filename);
+
+    deg.assign(ids.size(), 0);
+    scanIndices([&](Index u, Index v) {
+      deg[u]++;
+      deg[v]++;
+      edges++;
+    });
+    state.assign(ids.size(), Undecided);
+  }
+
+  Index countVertices() const {
+    return ids.size();
+  }
+
+  // Lines of the file, duplicates included
+  uint64_t countEdges() const {
+    return edges;
+  }
+
+  Index index(Vertex v) const {
+    return std::lower_bound(ids.begin(), ids.end(), v) - ids.begin();
+  }
+
+  void solve_greedy() {
+    complete();
+  }
+
+  // One round of 1-swaps, in five passes and a complete(). A vertex is
+  // 1-tight when it is Out with a single In neighbor, its owner. An owner
+  // u with two non adjacent 1-tight neighbors v and w is replaced by them.
+  // Edges listed twice, in either direction, must not make a 1-tight
+  // vertex look 2-tight. Returns how much the set grew.
+  size_t improve() {
+    size_t n = ids.size(), before = size();
+    std::vector<uint8_t> tight(n, 0);
+    std::vector<Index> owner(n, None);
+    scanIndices([&](Index u, Index v) {
+      if(state[u] == Out && state[v] == In && tight[u] < 2 && (tight[u] == 0 || owner[u] != v)) {
+        tight[u]++;
+        owner[u] = v;
+      }
+      if(state[v] == Out && state[u] == In && tight[v] < 2 && (tight[v] == 0 || owner[v] != u)) {
+        tight[v]++;
+        owner[v] = u;
+      }
+    });
+    auto siblings = [&](Index u, Index v) {
+      return tight[u] == 1 && tight[v] == 1 && owner[u] == owner[v];
+    };
+
+    // Adjacent siblings of each 1-tight vertex. Only a repeat of the last
+    // sibling counted is caught, so duplicated edges may still inflate the
+    // count, which then only steers the choice below
+    std::vector<Index> count(n, 0), last(n, None);
+    scanIndices([&](Index u, Index v) {
+      if(siblings(u, v)) {
+        if(last[u] != v)
+          count[u]++;
+        if(last[v] != u)
+          count[v]++;
+        last[u] = v;
+        last[v] = u;
+      }
+    });
+
+    // Each owner picks the 1-tight neighbor with the fewest adjacent
+    // siblings. Should it be adjacent to all of them, the pass below
+    // excludes every sibling and the owner stays
+    std::vector<Index> chosen(n, None), partner(n, None);
+    for(Index v = 0; v < n; v++) {
+      Index u = owner[v];
+      if(tight[v] == 1 && (chosen[u] == None || count[v] < count[chosen[u]]))
+        chosen[u] = v;
+    }
+    std::vector<bool> excluded(n, false);
+    scanIndices([&](Index u, Index v) {
+      if(siblings(u, v)) {
+        if(chosen[owner[u]] == u)
+          excluded[v] = true;
+        else if(chosen[owner[v]] == v)
+          excluded[u] = true;
+      }
+    });
+    for(Index w = 0; w < n; w++) {
+      Index u = owner[w];
+      if(tight[w] == 1 && chosen[u] != None && chosen[u] != w && !excluded[w] && partner[u] == None)
+        partner[u] = w;
+    }
+
+    for(Index u = 0; u < n; u++) {
+      if(partner[u] != None) {
+        state[u] = Out;
+        state[chosen[u]] = In;
+        state[partner[u]] = In;
+      }
+    }
+    // Only vertices swapped in can now be adjacent, from two swaps made
+    // side by side: the later owner takes its place back
+    scanIndices([&](Index u, Index v) {
+      if(state[u] == In && state[v] == In) {
+        Index x = std::max(owner[u], owner[v]);
+        state[x] = In;
+        state[chosen[x]] = Out;
+        state[partner[x]] = Out;
+        partner[x] = None;
+      }
+    });
+
+    // Any Out neighbor of a swapped owner may have lost its only In
+    // neighbor, 1-tight or not: a vertex next to two owners that are both
+    // swapped ends up with none. complete() decides them again
+    scanIndices([&](Index u, Index v) {
+      if(state[u] == Out && partner[v] != None)
+        state[u] = Undecided;
+      if(state[v] == Out && partner[u] != None)
+        state[v] = Undecided;
+    });
+    complete();
+    return size() - before;
+  }
+
+  size_t size() const {
+    return std::count(state.begin(), state.end(), In);
+  }
+
+  FlatSet<Vertex> solution() const {
+    FlatSet<Vertex> ret;
+    ret.reserve(size());
+    for(Index u = 0; u < ids.size(); u++)
+      if(state[u] == In)
+        ret.insert(ids[u]);
+    return ret;
+  }
+
+  int countPasses() const {
+    return passes;
+  }
+
+  // Bytes read from the file over all passes
+  uint64_t bytesRead() const {
+    return bytes;
+  }
+
+  // Bytes of the per-vertex arrays kept between passes
+  size_t memoryBytes() const {
+    return ids.capacity() * sizeof(Vertex) + deg.capacity() * sizeof(uint32_t) + state.capacity();
+  }
+};
+
+#endif
@@ -4,12 +4,14 @@
 
 #include "Graph.hpp"
 #include "tools.hpp"
+#include "PeelGraph.hpp"
 #include <iostream>
 #include <unordered_set>
 #include <queue>
 #include <cassert>
 #include <random>
 #include <optional>
+#include <ranges>
 
 using Generator = std::mt19937;
 using Distributor = std::uniform_int_distribution<std::size_t>;
@@ -20,9 +22,9 @@ class Solver
     mutable Generator rng;
     
     const Graph<Vertex> &g;
-    std::unordered_set<Vertex> independant;
+    FlatSet<Vertex> independant;
     std::vector<Vertex> vertices;
-    std::unordered_map<Vertex, int> dependancy;
+    FlatMap<Vertex, int> dependancy;
 
 public:
     Solver(const Graph<Vertex> &_g):
@@ -40,19 +42,16 @@ public:
         }
     }
 
+    // Takes a vertex of smallest degree in what is left, then peels it
+    // with its neighbors
     void solve_greedy()
     {
-        auto queue = vertices;
-            std::sort(queue.begin(), queue.end(),
-                [this](const Vertex& a, const Vertex& b) -> bool {
-                    return g.degree(a) < g.degree(b);
-                });
-        
-        while(!queue.empty()) {
-            Vertex& v = queue.front();
-            independant.insert(v);
-            incrementNeighbors(v); // Update the count (or add the neighbor)
-            removeNeighborsFromQueue(queue, v);
+        PeelGraph peel = peelGraph();
+        while(!peel.empty()) {
+            int i = peel.minDegreeVertex();
+            independant.insert(vertices[i]);
+            incrementNeighbors(vertices[i]); // Update the count (or add the neighbor)
+            peel.removeClosed(i);
         }
     }
 
@@ -72,7 +71,7 @@ public:
     }
 
     // Getter for the solution
-    const std::unordered_set<Vertex>& solution()
+    const FlatSet<Vertex>& solution()
     {
         return independant;
     }
@@ -92,16 +91,16 @@ private:
         }
     }
 
-    void removeNeighborsFromQueue(std::vector<Vertex>& list, Vertex& v)
+    // Same graph on the indices of vertices
+    PeelGraph peelGraph() const
     {
-        // capture closed by value to avoid binding a reference to a temporary
-        auto closed = g.closedNeighbors(v);
-        list.erase(
-            std::remove_if(list.begin(), list.end(),
-                [closed](const Vertex& n) { return closed.contains(n); }
-            ),
-            list.end()
-        );
+        FlatMap<Vertex, int> index;
+        for (int i = 0; i < (int)vertices.size(); i++)
+            index[vertices[i]] = i;
+        return PeelGraph(vertices.size(), [&](int i) {
+            return g.neighbors(vertices[i])
+                | std::views::transform([&](const Vertex& u) { return index.at(u); });
+        });
     }
 
     std::optional<Vertex> randomNeighborless() const
@@ -135,7 +134,7 @@ private:
 
 // Save the solution to a file
 template <class Vertex>
-void save(const std::string &outfn, std::unordered_set<Vertex> solution)
+void save(const std::string &outfn, const FlatSet<Vertex> &solution)
 {
     std::ofstream outfile(outfn);
     for (Vertex v : solution)
@@ -0,0 +1,59 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <vector>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <cstddef>
+
+// Bounded lock-free queue between one producer thread and one consumer
+// thread. Each side owns one index of the ring and only reads the other
+// one, with acquire/release ordering, so a value is fully written before
+// it can be popped. The indices sit on their own cache lines. Waiting on a
+// full or empty ring yields the core, so both sides can share one.
+template<class T>
+class SpscQueue {
+  std::vector<T> ring;
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+  alignas(64) std::atomic<bool> closed{false};
+
+public:
+  explicit SpscQueue(size_t capacity) : ring(capacity) {
+  }
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  void push(T x) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    while(t - head.load(std::memory_order_acquire) == ring.size())
+      std::this_thread::yield();
+    ring[t % ring.size()] = std::move(x);
+    tail.store(t + 1, std::memory_order_release);
+  }
+
+  // No push may follow
+  void close() {
+    closed.store(true, std::memory_order_release);
+  }
+
+  // Next value, nothing once the queue is closed and drained
+  std::optional<T> pop() {
+    size_t h = head.load(std::memory_order_relaxed);
+    while(tail.load(std::memory_order_acquire) == h) {
+      // Pushes before close() are visible once closed is
+      if(closed.load(std::memory_order_acquire) && tail.load(std::memory_order_acquire) == h)
+        return std::nullopt;
+      std::this_thread::yield();
+    }
+    std::optional<T> ret(std::move(ring[h % ring.size()]));
+    ring[h % ring.size()] = T();
+    head.store(h + 1, std::memory_order_release);
+    return ret;
+  }
+};
+
+#endif
@@ -1,6 +1,6 @@
 #!/bin/bash
 
-g++ -Wfatal-errors -std=c++20 -Ofast -o main main.cpp
+g++ -Wfatal-errors -std=c++20 -pthread -Ofast -o main main.cpp
 
 for a in ../instances/*.edges
 do
@@ -8,3 +8,10 @@ do
  python testind.py $a ${a%.edges}.ind
 done
 
+# Regression: a vertex whose two In neighbors are both swapped out in the
+# same round must be decided again
+for a in input/*.edges
+do
+ ./main --external $a
+ python testind.py $a ${a%.edges}.ind
+done
@@ -1,7 +1,9 @@
 // BERTOLINI Garice
 #include <iostream>
+#include <filesystem>
 #include "Graph.hpp"
 #include "Solver.hpp"
+#include "SemiExternal.hpp"
 #include "tools.hpp"
 
 using namespace std;
@@ -9,17 +11,42 @@ using Vertex = long long int;
 
 double maxtime = 120;
 
+// Greedy then 1-swap rounds with the edges left on disk
+FlatSet<Vertex> solveExternal(const string &fn) {
+  SemiExternalMIS<Vertex> solver(fn);
+  cout << "Scanned input graph with " << solver.countVertices() << " vertices and "
+       << solver.countEdges() << " edges, keeping " << solver.memoryBytes() / 1024 << "KB in memory" << endl;
+
+  solver.solve_greedy();
+  cout << "Independant set size: " << solver.size() << " after " << solver.countPasses() << " passes" << endl;
+
+  int rounds = 0;
+  while(elapsed() < maxtime && solver.improve() > 0)
+    rounds++;
+  cout << "After " << rounds << " swap rounds, size " << solver.size() << ", "
+       << solver.countPasses() << " passes and " << solver.bytesRead() / (1 << 20) << "MB read" << endl;
+  return solver.solution();
+}
+
 int main(int argc, char **argv) {
-  if(argc != 2) {
-    cout << "./main <inputfile>" << endl;
+  bool external = argc == 3 && string(argv[1]) == "--external";
+  if(argc != 2 && !external) {
+    cout << "./main [--external] <inputfile>" << endl;
     exit(1);
   }
+  string fn = argv[argc - 1];
+  if(external) {
+    save(filesystem::path(fn).replace_extension(".ind"), solveExternal(fn));
+    return 0;
+  }
 
-  Graph<Vertex> g(argv[1]); // Read input graph
+  Graph<Vertex> g(fn); // Read input graph
   cout << "Read input graph with " << g.countVertices() << " vertices and "
-                                   << g.countEdges() << " edges" << endl;
+                                   << g.countEdges() << " edges in "
+                                   << g.loadTimes().total << "s (parse " << g.loadTimes().parse
+                                   << "s, build " << g.loadTimes().build << "s)" << endl;
 
-  std::unordered_set<Vertex> solution;
+  FlatSet<Vertex> solution;
 
   while(elapsed() < maxtime) {
     int iterations = 0;
@@ -53,8 +80,7 @@ int main(int argc, char **argv) {
               << std::endl;
   }
 
-  string outfn = argv[1]; // Create filename for output
-  outfn.replace(outfn.end()-5, outfn.end(), "ind");
+  string outfn = filesystem::path(fn).replace_extension(".ind"); // Create filename for output
   save(outfn, solution);
   
   return 0;
@@ -50,6 +50,11 @@ def testInd(G,E,I):
       err.add(u)
       err.add(v)
 
+  for v in G:
+    if v not in I and not G[v] & I:
+      print("Vertex could be added:", v)
+      err.add(v)
+
   return err
 
 
@@ -0,0 +1,406 @@
+#ifndef FLAT_HASH_HPP
+#define FLAT_HASH_HPP
+
+#include <vector>
+#include <utility>
+#include <memory>
+#include <memory_resource>
+#include <functional>
+#include <iterator>
+#include <initializer_list>
+#include <tuple>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+// Finalizer of MurmurHash3: each input bit flips each output bit with
+// probability close to 1/2, so the low bits that pick a slot are as good
+// as the high ones
+inline uint64_t mixHash(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+inline uint64_t hashCombine(uint64_t h, uint64_t v) {
+  return mixHash(h ^ (mixHash(v) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+}
+
+// Integers are mixed directly, other keys through their std::hash
+template<class K>
+struct FlatHash {
+  uint64_t operator()(const K &k) const {
+    if constexpr(std::is_integral_v<K>)
+      return mixHash(uint64_t(k));
+    else
+      return mixHash(std::hash<K>{}(k));
+  }
+};
+
+// Open addressing with linear probing and Robin Hood displacement, in two
+// flat arrays: the slots and the probe length of each. Lookups stop as soon
+// as they meet a slot closer to its home than they are to theirs, and
+// erasure shifts the rest of the run back instead of leaving tombstones.
+// Capacity is a power of two, at most 7/8 full. Slots must be default
+// constructible. Insertion and erasure invalidate iterators and references.
+template<class Key, class Slot, class KeyOf, class Hash, class Alloc>
+class FlatTable {
+public:
+  using key_type = Key;
+  using value_type = Slot;
+  using size_type = size_t;
+  using allocator_type = Alloc;
+
+protected:
+  using DistAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<uint8_t>;
+
+  // Probe length + 1 of each slot, 0 when empty
+  std::vector<uint8_t, DistAlloc> dist;
+  std::vector<Slot, Alloc> slots;
+  size_t used = 0;
+
+  static constexpr int MaxDist = 250;
+
+  size_t mask() const {
+    return slots.size() - 1;
+  }
+
+  size_t home(const Key &k) const {
+    return Hash{}(k) & mask();
+  }
+
+  // Slot built with the allocator of the table, for pmr values
+  template<class... Args>
+  Slot make(Args &&...args) const {
+    return std::make_obj_using_allocator<Slot>(slots.get_allocator(), std::forward<Args>(args)...);
+  }
+
+  // Slot of k, slots.size() when absent
+  size_t locate(const Key &k) const {
+    if(used == 0)
+      return slots.size();
+    size_t i = home(k);
+    for(int d = 1; dist[i] >= d; d++, i = (i + 1) & mask())
+      if(KeyOf{}(slots[i]) == k)
+        return i;
+    return slots.size();
+  }
+
+  void rehash(size_t n) {
+    std::vector<uint8_t, DistAlloc> oldDist(n, 0, dist.get_allocator());
+    std::vector<Slot, Alloc> oldSlots(n, slots.get_allocator());
+    dist.swap(oldDist);
+    slots.swap(oldSlots);
+    used = 0;
+    for(size_t i = 0; i < oldSlots.size(); i++)
+      if(oldDist[i])
+        place(std::move(oldSlots[i]));
+  }
+
+  // Inserts s, whose key is absent, and returns its slot
+  size_t place(Slot s) {
+    if((used + 1) * 8 > slots.size() * 7)
+      rehash(slots.empty() ? 8 : 2 * slots.size());
+
+    Key k = KeyOf{}(s);
+    size_t i = home(k), ret = slots.size();
+    for(int d = 1;; d++, i = (i + 1) & mask()) {
+      if(d > MaxDist) {
+        // Too long a run, only with a poor hash: grow and place the
+        // displaced slot again
+        rehash(2 * slots.size());
+        place(std::move(s));
+        return locate(k);
+      }
+      if(dist[i] == 0) {
+        dist[i] = d;
+        slots[i] = std::move(s);
+        used++;
+        return ret == slots.size() ? i : ret;
+      }
+      if(dist[i] < d) {
+        int e = dist[i];
+        dist[i] = d;
+        d = e;
+        std::swap(s, slots[i]);
+        if(ret == slots.size())
+          ret = i;
+      }
+    }
+  }
+
+  void eraseSlot(size_t i) {
+    for(size_t j = (i + 1) & mask(); dist[j] > 1; i = j, j = (j + 1) & mask()) {
+      slots[i] = std::move(slots[j]);
+      dist[i] = dist[j] - 1;
+    }
+    dist[i] = 0;
+    slots[i] = make();
+    used--;
+  }
+
+  template<bool Const>
+  class Iterator {
+    friend class FlatTable;
+    using Table = std::conditional_t<Const, const FlatTable, FlatTable>;
+    Table *t = nullptr;
+    size_t i = 0;
+
+    void skip() {
+      while(i < t->slots.size() && t->dist[i] == 0)
+        i++;
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Slot;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const Slot *, Slot *>;
+    using reference = std::conditional_t<Const, const Slot &, Slot &>;
+
+    Iterator() {
+    }
+
+    Iterator(Table *_t, size_t _i) : t(_t), i(_i) {
+      skip();
+    }
+
+    operator Iterator<true>() const {
+      return {t, i};
+    }
+
+    reference operator*() const {
+      return t->slots[i];
+    }
+
+    pointer operator->() const {
+      return &t->slots[i];
+    }
+
+    Iterator &operator++() {
+      i++;
+      skip();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return i == other.i;
+    }
+  };
+
+public:
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatTable() {
+  }
+
+  explicit FlatTable(const Alloc &alloc) : dist(alloc), slots(alloc) {
+  }
+
+  // Copies and moves take the allocator the way std containers do
+  FlatTable(const FlatTable &other, const Alloc &alloc)
+    : dist(other.dist, alloc), slots(other.slots, alloc), used(other.used) {
+  }
+
+  // Moved from tables are left empty
+  FlatTable(FlatTable &&other, const Alloc &alloc)
+    : dist(std::move(other.dist), alloc), slots(std::move(other.slots), alloc), used(other.used) {
+    other.clear();
+  }
+
+  FlatTable(const FlatTable &) = default;
+  FlatTable &operator=(const FlatTable &) = default;
+
+  FlatTable(FlatTable &&other) noexcept
+    : dist(std::move(other.dist)), slots(std::move(other.slots)), used(other.used) {
+    other.clear();
+  }
+
+  FlatTable &operator=(FlatTable &&other) {
+    if(this != &other) {
+      dist = std::move(other.dist);
+      slots = std::move(other.slots);
+      used = other.used;
+      other.clear();
+    }
+    return *this;
+  }
+
+  allocator_type get_allocator() const {
+    return slots.get_allocator();
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, slots.size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, slots.size()); }
+
+  size_t size() const {
+    return used;
+  }
+
+  bool empty() const {
+    return used == 0;
+  }
+
+  // Slots, for memory accounting
+  size_t capacity() const {
+    return slots.size();
+  }
+
+  // Room for n keys without rehashing
+  void reserve(size_t n) {
+    size_t cap = 8;
+    while(cap * 7 < n * 8)
+      cap *= 2;
+    if(cap > slots.size())
+      rehash(cap);
+  }
+
+  void clear() {
+    std::vector<uint8_t, DistAlloc>(dist.get_allocator()).swap(dist);
+    std::vector<Slot, Alloc>(slots.get_allocator()).swap(slots);
+    used = 0;
+  }
+
+  iterator find(const Key &k) {
+    return iterator(this, locate(k));
+  }
+
+  const_iterator find(const Key &k) const {
+    return const_iterator(this, locate(k));
+  }
+
+  bool contains(const Key &k) const {
+    return locate(k) != slots.size();
+  }
+
+  size_t erase(const Key &k) {
+    size_t i = locate(k);
+    if(i == slots.size())
+      return 0;
+    eraseSlot(i);
+    return 1;
+  }
+
+  void erase(const_iterator it) {
+    eraseSlot(it.i);
+  }
+
+  // Backward shifts only move slots to lower positions, or from the front
+  // to the back, so rechecking the current slot visits every one
+  template<class Pred>
+  friend size_t erase_if(FlatTable &t, Pred pred) {
+    size_t before = t.used;
+    for(size_t i = 0; i < t.slots.size();) {
+      if(t.dist[i] && pred(std::as_const(t.slots[i])))
+        t.eraseSlot(i);
+      else
+        i++;
+    }
+    return before - t.used;
+  }
+};
+
+template<class Key>
+struct SetKey {
+  const Key &operator()(const Key &k) const {
+    return k;
+  }
+};
+
+template<class Key, class Value>
+struct MapKey {
+  const Key &operator()(const std::pair<Key, Value> &s) const {
+    return s.first;
+  }
+};
+
+template<class Key, class Hash = FlatHash<Key>, class Alloc = std::allocator<Key>>
+class FlatSet : public FlatTable<Key, Key, SetKey<Key>, Hash, Alloc> {
+  using Table = FlatTable<Key, Key, SetKey<Key>, Hash, Alloc>;
+
+public:
+  using Table::Table;
+
+  template<class It>
+  FlatSet(It first, It last, const Alloc &alloc = Alloc()) : Table(alloc) {
+    insert(first, last);
+  }
+
+  FlatSet(std::initializer_list<Key> keys) {
+    insert(keys.begin(), keys.end());
+  }
+
+  size_t count(const Key &k) const {
+    return this->contains(k);
+  }
+
+  // Whether k was inserted
+  bool insert(const Key &k) {
+    if(this->locate(k) != this->slots.size())
+      return false;
+    this->place(this->make(k));
+    return true;
+  }
+
+  template<class It>
+  void insert(It first, It last) {
+    for(; first != last; ++first)
+      insert(*first);
+  }
+};
+
+template<class Key, class Value, class Hash = FlatHash<Key>, class Alloc = std::allocator<std::pair<Key, Value>>>
+class FlatMap : public FlatTable<Key, std::pair<Key, Value>, MapKey<Key, Value>, Hash, Alloc> {
+  using Table = FlatTable<Key, std::pair<Key, Value>, MapKey<Key, Value>, Hash, Alloc>;
+
+public:
+  using mapped_type = Value;
+  using Table::Table;
+
+  size_t count(const Key &k) const {
+    return this->contains(k);
+  }
+
+  Value &operator[](const Key &k) {
+    size_t i = this->locate(k);
+    if(i == this->slots.size())
+      i = this->place(this->make(std::piecewise_construct, std::forward_as_tuple(k), std::forward_as_tuple()));
+    return this->slots[i].second;
+  }
+
+  Value &at(const Key &k) {
+    size_t i = this->locate(k);
+    if(i == this->slots.size())
+      throw std::out_of_range("FlatMap::at");
+    return this->slots[i].second;
+  }
+
+  const Value &at(const Key &k) const {
+    size_t i = this->locate(k);
+    if(i == this->slots.size())
+      throw std::out_of_range("FlatMap::at");
+    return this->slots[i].second;
+  }
+};
+
+// Same containers on a memory resource, like std::pmr ones
+template<class Key, class Hash = FlatHash<Key>>
+using PmrFlatSet = FlatSet<Key, Hash, std::pmr::polymorphic_allocator<Key>>;
+
+template<class Key, class Value, class Hash = FlatHash<Key>>
+using PmrFlatMap = FlatMap<Key, Value, Hash, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+
+#endif
@@ -2,33 +2,158 @@
 #define GRAPH_HPP
 
 #include <fstream>
-#include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
 #include <vector>
 #include <queue>
 #include <cassert>
+#include <iterator>
+#include <cstddef>
+#include <chrono>
+#include "EdgeReader.hpp"
+#include "CompactGraph.hpp"
+#include "FlatHash.hpp"
 
 
 template <class Vertex>
 using Edge = std::pair<Vertex, Vertex>;
 
+// Each edge u < v of an adjacency map once, built on the fly by walking
+// the neighbor sets: O(V+E) for a full pass and no allocation
 template <class Vertex>
-struct EdgeHash {
-    std::size_t operator()(const std::pair<Vertex, Vertex>& e) const noexcept {
-        auto h1 = std::hash<Vertex>{}(e.first);
-        auto h2 = std::hash<Vertex>{}(e.second);
-        return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+class EdgeIterator {
+  using Outer = typename FlatMap<Vertex, FlatSet<Vertex>>::const_iterator;
+  using Inner = typename FlatSet<Vertex>::const_iterator;
+  Outer outer, last;
+  Inner inner;
+
+  // Moves forward to the first u < v pair at or after the current one
+  void settle() {
+    while(outer != last) {
+      for(; inner != outer->second.end(); ++inner)
+        if(outer->first < *inner)
+          return;
+      if(++outer != last)
+        inner = outer->second.begin();
+    }
+  }
+
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = Edge<Vertex>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = Edge<Vertex>;
+
+  EdgeIterator() {
+  }
+
+  EdgeIterator(Outer first, Outer _last) : outer(first), last(_last) {
+    if(outer != last) {
+      inner = outer->second.begin();
+      settle();
     }
+  }
+
+  Edge<Vertex> operator*() const {
+    return {outer->first, *inner};
+  }
+
+  EdgeIterator &operator++() {
+    ++inner;
+    settle();
+    return *this;
+  }
+
+  EdgeIterator operator++(int) {
+    EdgeIterator ret = *this;
+    ++*this;
+    return ret;
+  }
+
+  bool operator==(const EdgeIterator &other) const {
+    return outer == other.outer && (outer == last || inner == other.inner);
+  }
+};
+
+template <class Vertex>
+struct EdgeRange {
+  EdgeIterator<Vertex> first, last;
+
+  EdgeIterator<Vertex> begin() const { return first; }
+  EdgeIterator<Vertex> end() const { return last; }
 };
 
+
+// Closed neighborhood of v as a view: v itself, then the neighbor set,
+// which is referenced and never copied
 template <class Vertex>
-using Edges = std::unordered_set<Edge<Vertex>, EdgeHash<Vertex>>;
+class ClosedNeighborhood {
+  Vertex v;
+  const FlatSet<Vertex> *neigh;
+
+public:
+  class iterator {
+    Vertex v;
+    bool self;
+    typename FlatSet<Vertex>::const_iterator it;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Vertex;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Vertex *;
+    using reference = const Vertex &;
 
+    iterator() {
+    }
+
+    iterator(Vertex _v, bool _self, typename FlatSet<Vertex>::const_iterator _it)
+      : v(_v), self(_self), it(_it) {
+    }
+
+    const Vertex &operator*() const {
+      return self ? v : *it;
+    }
+
+    iterator &operator++() {
+      if(self)
+        self = false;
+      else
+        ++it;
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    bool operator==(const iterator &other) const {
+      return self == other.self && it == other.it;
+    }
+  };
+
+  ClosedNeighborhood(Vertex _v, const FlatSet<Vertex> &_neigh) : v(_v), neigh(&_neigh) {
+  }
+
+  iterator begin() const { return iterator(v, true, neigh->begin()); }
+  iterator end() const { return iterator(v, false, neigh->end()); }
+
+  size_t size() const {
+    return neigh->size() + 1;
+  }
+
+  bool contains(Vertex u) const {
+    return u == v || neigh->count(u) != 0;
+  }
+};
 
 template<class Vertex>
 class Graph {
-  std::unordered_map<Vertex, std::unordered_set<Vertex>> adj;
+  FlatMap<Vertex, FlatSet<Vertex>> adj;
+  LoadTimes loaded;
   
 public:
   Graph() {
@@ -37,12 +162,56 @@ public:
     adj[v];
   }
   
+  // Parsed while being built, see pipelineEdges(), or copied from a snapshot
   Graph(std::string filename) {
-    std::ifstream infile(filename);
-    Vertex u,v;
-    while(infile >> u >> v) {
-      addEdge(u,v);
+    if (isGraphFile(filename)) {
+      CompactGraph<Vertex> c = CompactGraph<Vertex>::map(filename);
+      adj.reserve(c.countVertices());
+      for (uint32_t u = 0; u < c.countVertices(); u++) {
+        FlatSet<Vertex> &neigh = adj[c.id(u)];
+        neigh.reserve(c.degree(u));
+        for (uint32_t w : c.neighbors(u))
+          neigh.insert(c.id(w));
+      }
+      return;
+    }
+
+    // Builders own the sources that hash to them, and their parts are
+    // merged once the file is parsed
+    int builders = std::max(1, readerThreads() - 1);
+    std::vector<FlatMap<Vertex, FlatSet<Vertex>>> parts(builders);
+    auto owns = [&](int b, Vertex v) {
+      return builders == 1 || int(mixHash(v) % builders) == b;
+    };
+    loaded = pipelineEdges<Vertex>(filename, builders, [&](int b, const auto &edges) {
+      for (auto [u, v] : edges) {
+        if (owns(b, u))
+          parts[b][u].insert(v);
+        if (owns(b, v))
+          parts[b][v].insert(u);
+      }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    if (builders == 1)
+      adj = std::move(parts[0]);
+    else {
+      size_t sources = 0;
+      for (const auto &part : parts)
+        sources += part.size();
+      adj.reserve(sources);
+      for (auto &part : parts)
+        for (auto &[v, neigh] : part)
+          adj[v] = std::move(neigh);
     }
+    double merge = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    loaded.build += merge;
+    loaded.total += merge;
+  }
+
+  // Stages of the load from an .edges file, zero for snapshots
+  const LoadTimes &loadTimes() const {
+    return loaded;
   }
 
   void addEdge(Vertex u, Vertex v) {
@@ -95,7 +264,7 @@ public:
   
   void removeVertex(Vertex v) {
     if(containsVertex(v)) {
-      std::unordered_set<Vertex> neigh(adj.at(v)); // Copy because changing the data structure invalidades the iterator
+      FlatSet<Vertex> neigh(adj.at(v)); // Copy because changing the data structure invalidades the iterator
       for(Vertex u : neigh) {
         removeEdge(u,v);
       }
@@ -115,35 +284,30 @@ public:
     return ret;
   }
 
-  Edges<Vertex> edges() const {
-    Edges<Vertex> s;
-    auto _ = vertices();
-    std::vector<Vertex> vs = std::vector(_.begin(), _.end());
+  // Lazy, in the unspecified order of the hash map
+  EdgeRange<Vertex> edges() const {
+    return {EdgeIterator<Vertex>(adj.begin(), adj.end()), EdgeIterator<Vertex>(adj.end(), adj.end())};
+  }
 
-    for (size_t i=0; i<vs.size()-1; ++i) {
-      for (size_t j=i+1; j<vs.size(); ++j) {
-        Vertex u = vs[i], v = vs[j];
-        
-        if (adj.at(u).count(v) != 0)
-          s.emplace(u, v);
-      }
-    }
-    return s;
+  // The same edges sorted, for a deterministic order. O(E log E).
+  std::vector<Edge<Vertex>> sortedEdges() const {
+    EdgeRange<Vertex> range = edges();
+    std::vector<Edge<Vertex>> ret(range.begin(), range.end());
+    std::sort(ret.begin(), ret.end());
+    return ret;
   }
   
-  const std::unordered_set<Vertex> &neighbors(Vertex v) const {
+  const FlatSet<Vertex> &neighbors(Vertex v) const {
     return adj.at(v);
   }
 
-  // Neighbors including v itself
-  std::unordered_set<Vertex> closedNeighbors(Vertex v) const {
-    std::unordered_set<Vertex> ret = neighbors(v);
-    ret.insert(v);
-    return ret;
+  // Neighbors including v itself, without copying them
+  ClosedNeighborhood<Vertex> closedNeighbors(Vertex v) const {
+    return ClosedNeighborhood<Vertex>(v, neighbors(v));
   }
   
   std::vector<Vertex> bfs(Vertex v, int maxv = 0) const {
-    std::unordered_set<Vertex> visited;
+    FlatSet<Vertex> visited;
     std::vector<Vertex> ret;
     std::queue<Vertex> fifo;
     
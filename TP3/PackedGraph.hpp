@@ -0,0 +1,199 @@
+#ifndef PACKED_GRAPH_HPP
+#define PACKED_GRAPH_HPP
+
+#include <algorithm>
+#include <vector>
+#include <span>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include "CompactGraph.hpp"
+
+// Read-only CompactGraph with compressed rows. Each sorted neighbor list is
+// stored as varints (7 bits per byte, high bit set on all but the last
+// byte): the first neighbor as a zigzag offset from the vertex itself, the
+// others as gaps minus one. Rows follow each other in one byte stream, so
+// only their byte offsets are kept. Small gaps, which a locality order such
+// as rcm or hilbert gives, take a single byte.
+template<class Vertex>
+class PackedGraph {
+public:
+  using Index = uint32_t;
+
+private:
+  std::vector<Vertex> ids;
+  std::vector<Index> byId;
+  std::vector<uint64_t> offsets{0};
+  std::vector<uint8_t> bytes;
+  uint64_t arcs = 0;
+
+  void put(uint64_t x) {
+    while(x >= 0x80) {
+      bytes.push_back(uint8_t(x) | 0x80);
+      x >>= 7;
+    }
+    bytes.push_back(uint8_t(x));
+  }
+
+  static uint64_t get(const uint8_t *&p) {
+    uint64_t x = *p & 0x7f;
+    for(int shift = 7; *p++ & 0x80; shift += 7)
+      x |= uint64_t(*p & 0x7f) << shift;
+    return x;
+  }
+
+public:
+  // Decodes one neighbor per step, ends at default_sentinel
+  class NeighborIterator {
+    const uint8_t *p = nullptr, *end = nullptr;
+    Index value = 0;
+    bool done = true;
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Index;
+    using difference_type = std::ptrdiff_t;
+
+    NeighborIterator() {
+    }
+
+    NeighborIterator(Index u, const uint8_t *_p, const uint8_t *_end) : p(_p), end(_end), done(p == end) {
+      if(!done) {
+        uint64_t z = get(p);
+        value = u + Index(int64_t(z >> 1) ^ -int64_t(z & 1));
+      }
+    }
+
+    Index operator*() const {
+      return value;
+    }
+
+    NeighborIterator &operator++() {
+      if(p == end)
+        done = true;
+      else
+        value += get(p) + 1;
+      return *this;
+    }
+
+    void operator++(int) {
+      ++*this;
+    }
+
+    bool operator==(std::default_sentinel_t) const {
+      return done;
+    }
+  };
+
+  struct NeighborRange {
+    NeighborIterator first;
+
+    NeighborIterator begin() const { return first; }
+    std::default_sentinel_t end() const { return {}; }
+  };
+
+  // Encodes g row by row, g may be mapped from a snapshot so that the
+  // uncompressed form never has to fit in memory
+  explicit PackedGraph(const CompactGraph<Vertex> &g) {
+    ids.resize(g.countVertices());
+    offsets.reserve(g.countVertices() + 1);
+    for(Index u = 0; u < g.countVertices(); u++) {
+      ids[u] = g.id(u);
+      std::span<const Index> neigh = g.neighbors(u);
+      for(size_t k = 0; k < neigh.size(); k++) {
+        if(k == 0) {
+          int64_t d = int64_t(neigh[0]) - u;
+          put(uint64_t(d << 1) ^ uint64_t(d >> 63));
+        }
+        else
+          put(neigh[k] - neigh[k - 1] - 1);
+      }
+      offsets.push_back(bytes.size());
+      arcs += neigh.size();
+    }
+    bytes.shrink_to_fit();
+
+    if(!std::is_sorted(ids.begin(), ids.end())) {
+      byId.resize(ids.size());
+      for(Index u = 0; u < byId.size(); u++)
+        byId[u] = u;
+      std::sort(byId.begin(), byId.end(), [&](Index a, Index b) { return ids[a] < ids[b]; });
+    }
+  }
+
+  Index countVertices() const {
+    return ids.size();
+  }
+
+  uint64_t countEdges() const {
+    return arcs / 2;
+  }
+
+  // Dense index of an original id, which must be in the graph
+  Index index(Vertex v) const {
+    if(byId.empty())
+      return std::lower_bound(ids.begin(), ids.end(), v) - ids.begin();
+    return *std::lower_bound(byId.begin(), byId.end(), v, [&](Index u, Vertex w) { return ids[u] < w; });
+  }
+
+  Vertex id(Index u) const {
+    return ids[u];
+  }
+
+  // One varint ends at each byte without the high bit
+  int degree(Index u) const {
+    int ret = 0;
+    for(uint64_t k = offsets[u]; k < offsets[u + 1]; k++)
+      ret += bytes[k] < 0x80;
+    return ret;
+  }
+
+  NeighborRange neighbors(Index u) const {
+    return {NeighborIterator(u, bytes.data() + offsets[u], bytes.data() + offsets[u + 1])};
+  }
+
+  bool containsEdge(Index u, Index v) const {
+    for(Index w : neighbors(u)) {
+      if(w >= v)
+        return w == v;
+    }
+    return false;
+  }
+
+  std::vector<Index> bfs(Index v, int maxv = 0) const {
+    std::vector<bool> visited(countVertices(), false);
+    std::vector<Index> ret;
+
+    if(maxv == 0)
+      maxv = countVertices();
+
+    // ret doubles as the queue, visited is set when a vertex is queued
+    ret.push_back(v);
+    visited[v] = true;
+    for(size_t i = 0; i < ret.size() && ret.size() < (size_t) maxv; i++) {
+      for(Index w : neighbors(ret[i])) {
+        if(!visited[w]) {
+          visited[w] = true;
+          ret.push_back(w);
+        }
+      }
+    }
+    if(ret.size() > (size_t) maxv)
+      ret.resize(maxv);
+
+    return ret;
+  }
+
+  // Bytes of the neighbor stream alone
+  size_t streamBytes() const {
+    return bytes.size();
+  }
+
+  // Bytes held by the arrays
+  size_t memoryBytes() const {
+    return ids.capacity() * sizeof(Vertex) + byId.capacity() * sizeof(Index)
+      + offsets.capacity() * sizeof(uint64_t) + bytes.capacity();
+  }
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef REORDER_HPP
+#define REORDER_HPP
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstdint>
+#include <stdexcept>
+#include "CompactGraph.hpp"
+
+// Vertex orders for CompactGraph::permute(). Each returns order with
+// order[i] the index that becomes i, so that neighbors end up close in
+// memory.
+
+// Instance ids encode points as x * 100000 + y, see testind.py
+template<class Vertex>
+std::pair<uint32_t, uint32_t> decodeCoordinates(Vertex v) {
+  return {uint32_t(v / 100000), uint32_t(v % 100000)};
+}
+
+// Decreasing degree, hubs first and packed together
+template<class Vertex>
+std::vector<uint32_t> degreeOrder(const CompactGraph<Vertex> &g) {
+  std::vector<uint32_t> order(g.countVertices());
+  for(uint32_t u = 0; u < order.size(); u++)
+    order[u] = u;
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return g.degree(a) > g.degree(b);
+  });
+  return order;
+}
+
+// Reverse Cuthill-McKee: BFS from a minimum degree vertex of each
+// component, neighbors queued by increasing degree, then reversed. Keeps
+// the bandwidth |i - j| of edges small.
+template<class Vertex>
+std::vector<uint32_t> rcmOrder(const CompactGraph<Vertex> &g) {
+  uint32_t n = g.countVertices();
+  std::vector<uint32_t> bydegree(n), order;
+  for(uint32_t u = 0; u < n; u++)
+    bydegree[u] = u;
+  std::stable_sort(bydegree.begin(), bydegree.end(), [&](uint32_t a, uint32_t b) {
+    return g.degree(a) < g.degree(b);
+  });
+
+  std::vector<bool> visited(n, false);
+  order.reserve(n);
+  for(uint32_t root : bydegree) {
+    if(visited[root])
+      continue;
+    // order doubles as the queue
+    size_t head = order.size();
+    order.push_back(root);
+    visited[root] = true;
+    for(; head < order.size(); head++) {
+      size_t first = order.size();
+      for(uint32_t w : g.neighbors(order[head])) {
+        if(!visited[w]) {
+          visited[w] = true;
+          order.push_back(w);
+        }
+      }
+      std::stable_sort(order.begin() + first, order.end(), [&](uint32_t a, uint32_t b) {
+        return g.degree(a) < g.degree(b);
+      });
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+// Position of (x, y) along the Hilbert curve filling [0, 2^bits)^2
+inline uint64_t hilbertIndex(uint32_t x, uint32_t y, int bits) {
+  uint64_t d = 0;
+  for(uint32_t s = uint32_t(1) << (bits - 1); s > 0; s /= 2) {
+    uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+    d += (uint64_t) s * s * ((3 * rx) ^ ry);
+    // Rotate the quadrant so that the curve inside it starts at its corner
+    if(ry == 0) {
+      if(rx == 1) {
+        x = s - 1 - (x & (s - 1));
+        y = s - 1 - (y & (s - 1));
+      }
+      std::swap(x, y);
+    }
+    x &= s - 1;
+    y &= s - 1;
+  }
+  return d;
+}
+
+// Hilbert curve order of the points coordinates(id) gives, for graphs
+// whose edges join nearby points
+template<class Vertex, class F>
+std::vector<uint32_t> hilbertOrder(const CompactGraph<Vertex> &g, F coordinates) {
+  std::vector<std::pair<uint64_t, uint32_t>> keys(g.countVertices());
+  for(uint32_t u = 0; u < keys.size(); u++) {
+    auto [x, y] = coordinates(g.id(u));
+    keys[u] = {hilbertIndex(x, y, 32), u};
+  }
+  std::sort(keys.begin(), keys.end());
+
+  std::vector<uint32_t> order(keys.size());
+  for(size_t i = 0; i < keys.size(); i++)
+    order[i] = keys[i].second;
+  return order;
+}
+
+// degree, rcm or hilbert, the last one on decoded instance coordinates
+template<class Vertex>
+std::vector<uint32_t> reorder(const CompactGraph<Vertex> &g, const std::string &mode) {
+  if(mode == "degree")
+    return degreeOrder(g);
+  if(mode == "rcm")
+    return rcmOrder(g);
+  if(mode == "hilbert")
+    return hilbertOrder(g, decodeCoordinates<Vertex>);
+  throw std::invalid_argument("Unknown vertex order: " + mode);
+}
+
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
-#include "Graph.hpp"
+#include "CompactGraph.hpp"
+#include <vector>
 #include <filesystem>
 #include <unordered_set>
 #include <unordered_map>
@@ -18,18 +19,18 @@ class Solver
 {
 
 private:
-    Graph<Vertex>& g;
+    CompactGraph<Vertex>& g;
 
     IloEnv env;
     IloModel model;
     IloCplex cplex;
 
     std::unordered_set<Vertex> solution;
-    std::unordered_map<Vertex, IloNumVar> variables;
+    std::vector<IloNumVar> variables; // By dense index
     int maxtime;
 
 public:
-    Solver(Graph<Vertex> &g, int maxtime)
+    Solver(CompactGraph<Vertex> &g, int maxtime)
         : g(g),
           env(),
           model(env),
@@ -37,21 +38,21 @@ public:
           maxtime(maxtime)
     {
         /**/ std::cout << "Creating variables" << std::endl; /**/
-        for (Vertex v : g.vertices())
-            variables[v] = IloNumVar(env, 0.0, 1.0, ILOINT);
+        for (uint32_t v = 0; v < g.countVertices(); v++)
+            variables.push_back(IloNumVar(env, 0.0, 1.0, ILOINT));
 
         /**/ std::cout << "Creating constraints" << std::endl; /**/
-        for (Edge<Vertex> e : g.edges()) {
+        for (const auto &[u, v] : g.edges()) {
             IloExpr expr(env);
-            expr += variables[e.first] + variables[e.second];
+            expr += variables[u] + variables[v];
             model.add(expr <= 1);
             expr.end();
         }
 
         /**/ std::cout << "Setting objective" << std::endl; /**/
         IloExpr expr(env);
-        for (Vertex v : g.vertices())
-            expr += variables[v];
+        for (const IloNumVar &x : variables)
+            expr += x;
         model.add(IloMaximize(env, expr));
         expr.end();
     }
@@ -83,9 +84,9 @@ public:
         std::cout << "Solution is " << cplex.getCplexStatus() << std::endl;
 
         solution.clear();
-        for (Vertex v : g.vertices()) {
+        for (uint32_t v = 0; v < g.countVertices(); v++) {
             if (cplex.getValue(variables[v]) > 0.5)
-                solution.insert(v);
+                solution.insert(g.id(v));
         }
 
         std::ofstream outfile(fn);
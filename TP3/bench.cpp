@@ -0,0 +1,575 @@
+// Micro-benchmarks, ./bench <name> files...
+#include "Graph.hpp"
+#include "CompactGraph.hpp"
+#include "Reorder.hpp"
+#include "FlatHash.hpp"
+#include "PackedGraph.hpp"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+using Vertex = long long int;
+
+// Every heap allocation of the program goes through here
+static long allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if(void *p = malloc(size))
+    return p;
+  throw bad_alloc();
+}
+
+// Once inlined, GCC pairs these free calls with the builtin operator new
+// rather than the replacement above, which does come from malloc
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+#pragma GCC diagnostic pop
+
+double since(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Peak RSS of a child process that only runs f
+long childPeakKB(const function<void()> &f) {
+  pid_t pid = fork();
+  if(pid == 0) {
+    f();
+    _exit(0);
+  }
+  int status;
+  struct rusage usage;
+  wait4(pid, &status, 0, &usage);
+  return usage.ru_maxrss;
+}
+
+// Hash map graph against CompactGraph: memory, neighbor scans, edge
+// queries and a full BFS. Both must give the same answers.
+bool benchGraph(const string &fn) {
+  cout << fn << endl;
+
+  long base = childPeakKB([] {});
+  long hashKB = childPeakKB([&] { Graph<Vertex> g(fn); });
+  long compactKB = childPeakKB([&] { CompactGraph<Vertex> g(fn); });
+
+  auto start = chrono::steady_clock::now();
+  Graph<Vertex> g(fn);
+  double tHash = since(start);
+  start = chrono::steady_clock::now();
+  CompactGraph<Vertex> c(fn);
+  double tCompact = since(start);
+
+  cout << "  " << c.countVertices() << " vertices, " << c.countEdges() << " edges" << endl;
+  cout << "  load: hash " << tHash << "s, compact " << tCompact << "s" << endl;
+  cout << "  peak RSS over baseline: hash " << hashKB - base << "KB, compact " << compactKB - base
+       << "KB, compact arrays " << c.memoryBytes() / 1024 << "KB" << endl;
+
+  bool same = g.countVertices() == (int)c.countVertices() && g.countEdges() == (int)c.countEdges();
+
+  // Sum of neighbor ids over every vertex, the same in both
+  start = chrono::steady_clock::now();
+  Vertex sumHash = 0;
+  for(Vertex v : g.vertices())
+    for(Vertex u : g.neighbors(v))
+      sumHash += u;
+  double tScanHash = since(start);
+  start = chrono::steady_clock::now();
+  Vertex sumCompact = 0;
+  for(uint32_t v = 0; v < c.countVertices(); v++)
+    for(uint32_t u : c.neighbors(v))
+      sumCompact += c.id(u);
+  double tScanCompact = since(start);
+  same &= sumHash == sumCompact;
+  cout << "  neighbor scan: hash " << tScanHash << "s, compact " << tScanCompact << "s" << endl;
+
+  // Random pairs, half of them edges
+  mt19937 rng(1);
+  vector<pair<Vertex, Vertex>> queries;
+  for(int i = 0; i < 1000000 && c.countVertices() > 0; i++) {
+    uint32_t u = rng() % c.countVertices();
+    uint32_t v = rng() % c.countVertices();
+    if(i % 2 == 0 && c.degree(u) > 0)
+      v = c.neighbors(u)[rng() % c.degree(u)];
+    queries.emplace_back(c.id(u), c.id(v));
+  }
+  start = chrono::steady_clock::now();
+  long foundHash = 0;
+  for(const auto &[u, v] : queries)
+    foundHash += g.containsEdge(u, v);
+  double tQueryHash = since(start);
+  start = chrono::steady_clock::now();
+  long foundCompact = 0;
+  for(const auto &[u, v] : queries)
+    foundCompact += c.containsEdge(c.index(u), c.index(v));
+  double tQueryCompact = since(start);
+  same &= foundHash == foundCompact;
+  cout << "  " << queries.size() << " edge queries: hash " << tQueryHash << "s, compact " << tQueryCompact << "s" << endl;
+
+  if(c.countVertices() > 0) {
+    start = chrono::steady_clock::now();
+    vector<Vertex> bfsHash = g.bfs(c.id(0));
+    double tBfsHash = since(start);
+    start = chrono::steady_clock::now();
+    vector<uint32_t> bfsCompact = c.bfs(0);
+    double tBfsCompact = since(start);
+    same &= bfsHash.size() == bfsCompact.size();
+    cout << "  BFS of " << bfsCompact.size() << " vertices: hash " << tBfsHash << "s, compact " << tBfsCompact << "s" << endl;
+  }
+
+  cout << "  " << (same ? "same answers" : "answers differ!") << endl;
+  return same;
+}
+
+// Open and closed neighborhoods of every vertex, walked and queried the
+// way the solvers do. None of it may allocate.
+bool benchAlloc(const string &fn) {
+  cout << fn << endl;
+  Graph<Vertex> g(fn);
+  CompactGraph<Vertex> c(fn);
+  vector<Vertex> vertices;
+  for(Vertex v : g.vertices())
+    vertices.push_back(v);
+
+  long before = allocations;
+  auto start = chrono::steady_clock::now();
+  long sum = 0;
+  for(Vertex v : vertices) {
+    for(Vertex u : g.neighbors(v))
+      sum += u;
+    auto closed = g.closedNeighbors(v);
+    for(Vertex u : closed)
+      sum += closed.contains(u);
+  }
+  double tHash = since(start);
+  long hashAllocations = allocations - before;
+
+  before = allocations;
+  start = chrono::steady_clock::now();
+  for(uint32_t v = 0; v < c.countVertices(); v++)
+    for(uint32_t u : c.neighbors(v))
+      sum += c.containsEdge(u, v);
+  for(const auto &[u, v] : c.edges())
+    sum += u + v;
+  for(const auto &[u, v] : g.edges())
+    sum += u < v;
+  double tCompact = since(start);
+  long compactAllocations = allocations - before;
+
+  cout << "  hash graph neighborhoods: " << hashAllocations << " allocations in " << tHash << "s" << endl;
+  cout << "  compact graph and edge ranges: " << compactAllocations << " allocations in " << tCompact << "s"
+       << " (checksum " << sum << ")" << endl;
+  return hashAllocations == 0 && compactAllocations == 0;
+}
+
+// Adjacency of the instance as a map of sets, the way Graph holds it
+template<class Map>
+Map adjacency(const vector<pair<Vertex, Vertex>> &arcs) {
+  Map adj;
+  for(const auto &[u, v] : arcs)
+    adj[u].insert(v);
+  return adj;
+}
+
+// std::unordered_* against FlatSet and FlatMap on the ids of an instance:
+// building, lookups with half misses, counter updates and erasures, then
+// the whole adjacency. Both must give the same answers.
+bool benchHash(const string &fn) {
+  cout << fn << endl;
+  vector<pair<Vertex, Vertex>> arcs = symmetricArcs(readEdgeList<Vertex>(fn));
+  vector<Vertex> keys;
+  for(const auto &[u, v] : arcs)
+    if(keys.empty() || keys.back() != u)
+      keys.push_back(u);
+  shuffle(keys.begin(), keys.end(), mt19937(1));
+  vector<Vertex> queries;
+  mt19937 rng(2);
+  for(size_t i = 0; i < 4 * keys.size(); i++)
+    queries.push_back(i % 2 ? keys[rng() % keys.size()] : (Vertex) rng() * 7 + 1);
+  cout << "  " << keys.size() << " keys, " << queries.size() << " lookups, " << arcs.size() << " arcs" << endl;
+
+  bool ok = true;
+  auto run = [&](auto set, auto map, const string &name) {
+    auto start = chrono::steady_clock::now();
+    for(Vertex v : keys)
+      set.insert(v);
+    double tInsert = since(start);
+    start = chrono::steady_clock::now();
+    long found = 0;
+    for(Vertex v : queries)
+      found += set.count(v);
+    double tFind = since(start);
+    start = chrono::steady_clock::now();
+    for(Vertex v : queries)
+      map[v] += 1;
+    double tCount = since(start);
+    start = chrono::steady_clock::now();
+    for(size_t i = 0; i < keys.size(); i += 2)
+      set.erase(keys[i]);
+    double tErase = since(start);
+    cout << "  " << name << ": insert " << keys.size() / tInsert / 1e6 << "M/s, lookup "
+         << queries.size() / tFind / 1e6 << "M/s, map update " << queries.size() / tCount / 1e6
+         << "M/s, erase " << (keys.size() + 1) / 2 / tErase / 1e6 << "M/s" << endl;
+    return pair(found, set.size() + map.size());
+  };
+  auto stdAnswers = run(unordered_set<Vertex>(), unordered_map<Vertex, int>(), "std");
+  auto flatAnswers = run(FlatSet<Vertex>(), FlatMap<Vertex, int>(), "flat");
+  ok &= stdAnswers == flatAnswers;
+
+  using StdAdjacency = unordered_map<Vertex, unordered_set<Vertex>>;
+  using FlatAdjacency = FlatMap<Vertex, FlatSet<Vertex>>;
+  long base = childPeakKB([] {});
+  long stdKB = childPeakKB([&] { adjacency<StdAdjacency>(arcs); }) - base;
+  long flatKB = childPeakKB([&] { adjacency<FlatAdjacency>(arcs); }) - base;
+  auto start = chrono::steady_clock::now();
+  StdAdjacency stdAdj = adjacency<StdAdjacency>(arcs);
+  double tStd = since(start);
+  start = chrono::steady_clock::now();
+  FlatAdjacency flatAdj = adjacency<FlatAdjacency>(arcs);
+  double tFlat = since(start);
+  long edgesStd = 0, edgesFlat = 0;
+  start = chrono::steady_clock::now();
+  for(const auto &[u, v] : arcs)
+    edgesStd += stdAdj.at(v).count(u);
+  double tStdQuery = since(start);
+  start = chrono::steady_clock::now();
+  for(const auto &[u, v] : arcs)
+    edgesFlat += flatAdj.at(v).count(u);
+  double tFlatQuery = since(start);
+  ok &= edgesStd == edgesFlat && edgesFlat == (long) arcs.size();
+  cout << "  adjacency std: build " << tStd << "s, " << arcs.size() / tStdQuery / 1e6 << "M edge queries/s, "
+       << stdKB << "KB peak (" << stdKB * 8192.0 / arcs.size() << " bits/arc)" << endl;
+  cout << "  adjacency flat: build " << tFlat << "s, " << arcs.size() / tFlatQuery / 1e6 << "M edge queries/s, "
+       << flatKB << "KB peak (" << flatKB * 8192.0 / arcs.size() << " bits/arc)" << endl;
+  cout << "  " << (ok ? "same answers" : "answers differ!") << endl;
+  return ok;
+}
+
+// Text parsing against a .gbin snapshot of the same graph: load time,
+// first scan over the mapped pages and peak memory, for CompactGraph and
+// for the hash Graph built from either
+bool benchSnapshot(const string &fn) {
+  cout << fn << endl;
+  string snapshot = filesystem::temp_directory_path() / filesystem::path(fn).filename().replace_extension(".bench.gbin");
+  CompactGraph<Vertex>(fn).save(snapshot);
+  cout << "  " << filesystem::file_size(fn) / 1024 << "KB text, " << filesystem::file_size(snapshot) / 1024
+       << "KB snapshot" << endl;
+
+  auto scan = [](const CompactGraph<Vertex> &g) {
+    Vertex sum = 0;
+    for(uint32_t u = 0; u < g.countVertices(); u++)
+      for(uint32_t w : g.neighbors(u))
+        sum += g.id(w);
+    return sum;
+  };
+
+  auto start = chrono::steady_clock::now();
+  CompactGraph<Vertex> parsed(fn);
+  double tParse = since(start);
+  start = chrono::steady_clock::now();
+  CompactGraph<Vertex> mapped(snapshot);
+  double tMap = since(start);
+  start = chrono::steady_clock::now();
+  Vertex sumParsed = scan(parsed);
+  double tScanParsed = since(start);
+  start = chrono::steady_clock::now();
+  Vertex sumMapped = scan(mapped);
+  double tScanMapped = since(start);
+  // Comparing against the checksum keeps the scans in the children alive
+  long base = childPeakKB([] {});
+  long parsedKB = childPeakKB([&] { if(scan(CompactGraph<Vertex>(fn)) != sumParsed) _exit(1); }) - base;
+  long mappedKB = childPeakKB([&] { if(scan(CompactGraph<Vertex>(snapshot)) != sumParsed) _exit(1); }) - base;
+  bool ok = mapped.mapped() && sumParsed == sumMapped && parsed.countEdges() == mapped.countEdges();
+  cout << "  compact: parse " << tParse << "s, map " << tMap << "s, first scan " << tScanParsed << "s parsed, "
+       << tScanMapped << "s mapped, peak RSS " << parsedKB << "KB parsed, " << mappedKB << "KB mapped" << endl;
+
+  start = chrono::steady_clock::now();
+  Graph<Vertex> fromText(fn);
+  double tText = since(start);
+  start = chrono::steady_clock::now();
+  Graph<Vertex> fromSnapshot(snapshot);
+  double tSnapshot = since(start);
+  ok &= fromText.countEdges() == fromSnapshot.countEdges() && fromText.countVertices() == fromSnapshot.countVertices();
+  cout << "  hash graph: from text " << tText << "s, from snapshot " << tSnapshot << "s" << endl;
+
+  filesystem::remove(snapshot);
+  cout << "  " << (ok ? "same graphs" : "graphs differ!") << endl;
+  return ok;
+}
+
+// Neighbor scan, BFS over every component and greedy MIS in (degree, id)
+// order, on any graph with the CompactGraph interface. Returns the scan
+// checksum and the greedy size.
+template<class G>
+pair<long, long> traverse(const G &g, double &tScan, double &tBfs, double &tGreedy) {
+  uint32_t n = g.countVertices();
+  auto start = chrono::steady_clock::now();
+  long sum = 0;
+  for(uint32_t u = 0; u < n; u++)
+    for(uint32_t w : g.neighbors(u))
+      sum += w;
+  tScan = since(start);
+
+  start = chrono::steady_clock::now();
+  vector<bool> visited(n, false);
+  for(uint32_t root = 0; root < n; root++)
+    if(!visited[root])
+      for(uint32_t u : g.bfs(root))
+        visited[u] = true;
+  tBfs = since(start);
+
+  vector<pair<int, Vertex>> key(n);
+  for(uint32_t u = 0; u < n; u++)
+    key[u] = {g.degree(u), g.id(u)};
+  vector<uint32_t> order(n);
+  for(uint32_t u = 0; u < n; u++)
+    order[u] = u;
+  sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+  start = chrono::steady_clock::now();
+  vector<bool> blocked(n, false);
+  long size = 0;
+  for(uint32_t u : order) {
+    if(!blocked[u]) {
+      size++;
+      blocked[u] = true;
+      for(uint32_t w : g.neighbors(u))
+        blocked[w] = true;
+    }
+  }
+  tGreedy = since(start);
+  return {sum, size};
+}
+
+// PackedGraph against CompactGraph: bits per arc, then scan, BFS and
+// greedy throughput, in id order and in locality orders
+bool benchPacked(const string &fn) {
+  cout << fn << endl;
+  CompactGraph<Vertex> base(fn);
+  double arcs = 2.0 * base.countEdges();
+  cout << "  " << base.countVertices() << " vertices, " << base.countEdges() << " edges" << endl;
+
+  bool ok = true;
+  for(string mode : {"none", "rcm", "hilbert"}) {
+    CompactGraph<Vertex> g = mode == "none" ? base : base.permute(reorder(base, mode));
+    auto start = chrono::steady_clock::now();
+    PackedGraph<Vertex> p(g);
+    double tPack = since(start);
+
+    double scan[2], bfs[2], greedy[2];
+    auto compact = traverse(g, scan[0], bfs[0], greedy[0]);
+    auto packed = traverse(p, scan[1], bfs[1], greedy[1]);
+    ok &= compact == packed && p.countEdges() == g.countEdges();
+
+    cout << "  " << mode << ": packed in " << tPack << "s, neighbors " << p.streamBytes() * 8 / arcs
+         << " bits/arc against " << 8.0 * sizeof(uint32_t) << ", whole graph " << p.memoryBytes() * 8 / arcs
+         << " bits/arc against " << g.memoryBytes() * 8 / arcs << endl;
+    for(int i = 0; i < 2; i++)
+      cout << "    " << (i == 0 ? "compact" : "packed ") << ": scan " << arcs / scan[i] / 1e6 << "M arcs/s, BFS "
+           << arcs / bfs[i] / 1e6 << "M arcs/s, greedy " << arcs / greedy[i] / 1e6 << "M arcs/s" << endl;
+  }
+  cout << "  " << (ok ? "same answers" : "answers differ!") << endl;
+  return ok;
+}
+
+// Hardware cache misses of this thread between start() and stop(), when
+// perf events are allowed
+class CacheMisses {
+  int fd = -1;
+
+public:
+  CacheMisses() {
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  ~CacheMisses() {
+    if(fd != -1)
+      close(fd);
+  }
+
+  void start() {
+    if(fd != -1) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  // -1 when not available
+  long stop() {
+    long long count;
+    if(fd == -1)
+      return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if(read(fd, &count, sizeof(count)) != sizeof(count))
+      return -1;
+    return count;
+  }
+};
+
+string misses(long count) {
+  return count < 0 ? "n/a" : to_string(count / 1000) + "k";
+}
+
+// BFS over every component, greedy MIS in (degree, id) order and random
+// (1, k)-swaps on the result, on each vertex order. "none" keeps the id
+// order, "random" scatters neighbors the way hashing does. The greedy set
+// is the same whatever the order.
+bool benchReorder(const string &fn) {
+  cout << fn << endl;
+  CompactGraph<Vertex> base(fn);
+  uint32_t n = base.countVertices();
+  cout << "  " << n << " vertices, " << base.countEdges() << " edges" << endl;
+
+  CacheMisses counter;
+  bool ok = true;
+  long greedySize = -1;
+  for(string mode : {"none", "random", "degree", "rcm", "hilbert"}) {
+    auto start = chrono::steady_clock::now();
+    CompactGraph<Vertex> g = base;
+    if(mode == "random") {
+      vector<uint32_t> order(n);
+      for(uint32_t u = 0; u < n; u++)
+        order[u] = u;
+      shuffle(order.begin(), order.end(), mt19937(1));
+      g = base.permute(order);
+    }
+    else if(mode != "none")
+      g = base.permute(reorder(base, mode));
+    double tReorder = since(start);
+
+    // Mean |i - j| over edges
+    double gap = 0;
+    for(const auto &[u, v] : g.edges())
+      gap += v - u;
+    gap /= max<uint64_t>(g.countEdges(), 1);
+
+    vector<bool> visited(n, false);
+    start = chrono::steady_clock::now();
+    counter.start();
+    for(uint32_t root = 0; root < n; root++) {
+      if(visited[root])
+        continue;
+      vector<uint32_t> component = g.bfs(root);
+      for(uint32_t u : component)
+        visited[u] = true;
+    }
+    long bfsMisses = counter.stop();
+    double tBfs = since(start);
+
+    vector<uint32_t> byDegree(n);
+    for(uint32_t u = 0; u < n; u++)
+      byDegree[u] = u;
+    sort(byDegree.begin(), byDegree.end(), [&](uint32_t a, uint32_t b) {
+      return pair(g.degree(a), g.id(a)) < pair(g.degree(b), g.id(b));
+    });
+    vector<bool> in(n, false);
+    vector<int> tight(n, 0);
+    long size = 0;
+    start = chrono::steady_clock::now();
+    counter.start();
+    for(uint32_t v : byDegree) {
+      if(tight[v] == 0 && !in[v]) {
+        in[v] = true;
+        size++;
+        for(uint32_t w : g.neighbors(v))
+          tight[w]++;
+      }
+    }
+    long greedyMisses = counter.stop();
+    double tGreedy = since(start);
+    if(greedySize != -1 && size != greedySize)
+      ok = false;
+    greedySize = size;
+
+    // Swap a random vertex with its only neighbor in the set, then add
+    // the neighbors of that one left free
+    mt19937 rng(1);
+    long moves = 10L * n;
+    start = chrono::steady_clock::now();
+    counter.start();
+    for(long i = 0; i < moves && n > 0; i++) {
+      uint32_t v = rng() % n;
+      if(in[v] || tight[v] != 1)
+        continue;
+      uint32_t u = *find_if(g.neighbors(v).begin(), g.neighbors(v).end(), [&](uint32_t w) { return in[w]; });
+      in[u] = false;
+      for(uint32_t w : g.neighbors(u))
+        tight[w]--;
+      for(uint32_t x : g.neighbors(u)) {
+        if(!in[x] && tight[x] == 0) {
+          in[x] = true;
+          size++;
+          for(uint32_t w : g.neighbors(x))
+            tight[w]++;
+        }
+      }
+      size--;
+    }
+    long localMisses = counter.stop();
+    double tLocal = since(start);
+    for(const auto &[u, v] : g.edges())
+      ok &= !(in[u] && in[v]);
+
+    double m = 2.0 * g.countEdges();
+    cout << "  " << mode << ": reorder " << tReorder << "s, mean edge gap " << (long) gap << endl;
+    cout << "    BFS " << m / tBfs / 1e6 << "M arcs/s (" << misses(bfsMisses) << " misses), "
+         << "greedy " << m / tGreedy / 1e6 << "M arcs/s (" << misses(greedyMisses) << " misses, size " << greedySize << "), "
+         << "local search " << moves / tLocal / 1e6 << "M moves/s (" << misses(localMisses) << " misses, size " << size << ")" << endl;
+  }
+  cout << "  " << (ok ? "same greedy sets, valid swaps" : "orders disagree!") << endl;
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  if(argc < 3) {
+    cout << "./bench graph|alloc|reorder|hash|snapshot|packed files..." << endl;
+    exit(1);
+  }
+
+  string name = argv[1];
+  bool ok = true;
+  for(int i = 2; i < argc; i++) {
+    if(name == "graph")
+      ok &= benchGraph(argv[i]);
+    else if(name == "alloc")
+      ok &= benchAlloc(argv[i]);
+    else if(name == "reorder")
+      ok &= benchReorder(argv[i]);
+    else if(name == "hash")
+      ok &= benchHash(argv[i]);
+    else if(name == "snapshot")
+      ok &= benchSnapshot(argv[i]);
+    else if(name == "packed")
+      ok &= benchPacked(argv[i]);
+    else {
+      cout << "Unknown benchmark " << name << endl;
+      return 1;
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#!/bin/bash
+
+g++ bench.cpp -std=c++20 -pthread -Wfatal-errors -o bench -O3 -march=native
+./bench graph `ls -Sr ../instances/*.edges`
+./bench alloc `ls -Sr ../instances/*.edges`
+./bench reorder `ls -Sr ../instances/*.edges`
+./bench hash `ls -Sr ../instances/*.edges`
+./bench snapshot `ls -Sr ../instances/*.edges`
+./bench packed `ls -Sr ../instances/*.edges`
@@ -0,0 +1,49 @@
+// Converts .edges lists to .gbin snapshots that CompactGraph maps and
+// Graph loads without parsing.
+// g++ convert.cpp -std=c++20 -pthread -O3 -o convert
+// ./convert [--order=degree|rcm|hilbert] [--coordinates] files.edges...
+#include "CompactGraph.hpp"
+#include "Reorder.hpp"
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+
+using namespace std;
+using Vertex = long long int;
+
+int main(int argc, char **argv) {
+  string order;
+  bool coordinates = false;
+  vector<string> files;
+  for(int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if(arg.rfind("--order=", 0) == 0)
+      order = arg.substr(8);
+    else if(arg == "--coordinates")
+      coordinates = true;
+    else
+      files.push_back(arg);
+  }
+  if(files.empty()) {
+    cout << "./convert [--order=degree|rcm|hilbert] [--coordinates] files.edges..." << endl;
+    exit(1);
+  }
+
+  for(const string &fn : files) {
+    auto start = chrono::steady_clock::now();
+    uintmax_t inBytes = filesystem::file_size(fn);
+    CompactGraph<Vertex> g(fn);
+    if(!order.empty())
+      g = g.permute(reorder(g, order));
+    if(coordinates)
+      g.setCoordinates(decodeCoordinates<Vertex>);
+
+    string out = filesystem::path(fn).replace_extension(".gbin");
+    g.save(out);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << fn << " -> " << out << ": " << g.countVertices() << " vertices, " << g.countEdges() << " edges, "
+         << inBytes / 1024 << "KB -> " << filesystem::file_size(out) / 1024 << "KB in "
+         << seconds << "s" << endl;
+  }
+  return 0;
+}
@@ -5,6 +5,7 @@ g++ -o ind-cplex -L/opt/ibm/ILOG/CPLEX_Studio221/cplex/lib/x86-64_linux/static_p
 */
 #include "Solver.hpp"
 #include <iostream>
+#include <filesystem>
 #include <fstream>
 
 using namespace std;
@@ -19,14 +20,13 @@ int main(int argc, char **argv) {
   }
 
   /**/ cout << "File " << argv[1] << endl; /**/
-  Graph<Vertex> g(argv[1]); // Read input graph
+  CompactGraph<Vertex> g(argv[1]); // Read input graph
   
   Solver solver(g, maxtime);
   
   solver.solve();
 
-  string outfn = argv[1]; // Create filename for output
-  outfn.replace(outfn.end()-5, outfn.end(), "ind");
+  string outfn = filesystem::path(argv[1]).replace_extension(".ind"); // Create filename for output
 
   solver.save(outfn);
 
@@ -0,0 +1,104 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <memory_resource>
+#include <optional>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <algorithm>
+
+// Forwards to an upstream resource and counts the allocations going
+// through, split by phase
+class CountingResource : public std::pmr::memory_resource {
+  std::pmr::memory_resource *upstream;
+  int current = 0;
+
+public:
+  std::vector<std::string> phases;
+  std::vector<long> allocations, bytes;
+
+  CountingResource(std::vector<std::string> _phases,
+                   std::pmr::memory_resource *_upstream = std::pmr::get_default_resource())
+    : upstream(_upstream), phases(std::move(_phases)),
+      allocations(phases.size(), 0), bytes(phases.size(), 0) {
+  }
+
+  // Later allocations are counted for phase p
+  void phase(int p) {
+    current = p;
+  }
+
+  void clear() {
+    std::fill(allocations.begin(), allocations.end(), 0);
+    std::fill(bytes.begin(), bytes.end(), 0);
+  }
+
+  long totalBytes() const {
+    long ret = 0;
+    for(long b : bytes)
+      ret += b;
+    return ret;
+  }
+
+private:
+  void *do_allocate(size_t size, size_t align) override {
+    allocations[current]++;
+    bytes[current] += size;
+    return upstream->allocate(size, align);
+  }
+
+  void do_deallocate(void *p, size_t size, size_t align) override {
+    upstream->deallocate(p, size, align);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// Monotonic arena over a buffer kept from one reset to the next.
+// Deallocation is a no-op and reset() frees everything at once. A round
+// that outgrows the buffer gets more memory from upstream, and the next
+// reset enlarges the buffer, so steady state never reaches the global
+// allocator.
+class Arena : public std::pmr::memory_resource {
+  std::vector<std::byte> buffer;
+  CountingResource overflow{{"overflow"}};
+  std::optional<std::pmr::monotonic_buffer_resource> pool;
+
+public:
+  Arena(size_t size = 1 << 20) : buffer(size) {
+    pool.emplace(buffer.data(), buffer.size(), &overflow);
+  }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  void reset() {
+    pool.reset();
+    if(overflow.totalBytes() > 0)
+      buffer.resize(buffer.size() + overflow.totalBytes());
+    overflow.clear();
+    pool.emplace(buffer.data(), buffer.size(), &overflow);
+  }
+
+  size_t capacity() const {
+    return buffer.size();
+  }
+
+private:
+  void *do_allocate(size_t size, size_t align) override {
+    return pool->allocate(size, align);
+  }
+
+  void do_deallocate(void *p, size_t size, size_t align) override {
+    pool->deallocate(p, size, align);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+#endif
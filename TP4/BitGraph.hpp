@@ -0,0 +1,173 @@
+#ifndef BIT_GRAPH_HPP
+#define BIT_GRAPH_HPP
+
+#include <vector>
+#include <span>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include <memory_resource>
+
+// Adjacency matrix of a small induced subgraph, one bit per pair. Vertices
+// get local indices 0..n-1 in increasing id order. Rows are padded to a
+// multiple of 4 words so that loops over them vectorize.
+template<class Vertex>
+class BitGraph {
+public:
+  // Sets share the resource of the graph
+  using Set = std::pmr::vector<uint64_t>;
+
+private:
+  std::pmr::vector<Vertex> ids;
+  int words = 0;
+  std::pmr::vector<uint64_t> rows;
+
+  std::pmr::memory_resource *resource() const {
+    return rows.get_allocator().resource();
+  }
+
+public:
+  // Subgraph of host induced by vertices, host needs neighbors()
+  template<class G>
+  BitGraph(const G &host, std::span<const Vertex> vertices,
+           std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+    : ids(vertices.begin(), vertices.end(), mr), rows(mr) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    words = (ids.size() + 255) / 256 * 4;
+    rows.assign(ids.size() * words, 0);
+
+    for(int i = 0; i < size(); i++) {
+      for(Vertex w : host.neighbors(ids[i])) {
+        auto it = std::lower_bound(ids.begin(), ids.end(), w);
+        if(it != ids.end() && *it == w)
+          rows[(size_t) i * words + (it - ids.begin()) / 64] |= uint64_t(1) << ((it - ids.begin()) % 64);
+      }
+    }
+  }
+
+  int size() const {
+    return ids.size();
+  }
+
+  Vertex id(int i) const {
+    return ids[i];
+  }
+
+  std::span<const uint64_t> row(int i) const {
+    return {rows.data() + (size_t) i * words, (size_t) words};
+  }
+
+  bool adjacent(int i, int j) const {
+    return row(i)[j / 64] >> (j % 64) & 1;
+  }
+
+  // Set of all local vertices
+  Set fullSet() const {
+    Set s(words, 0, resource());
+    for(int i = 0; i < size(); i++)
+      s[i / 64] |= uint64_t(1) << (i % 64);
+    return s;
+  }
+
+  static int count(const Set &s) {
+    int ret = 0;
+    for(uint64_t w : s)
+      ret += std::popcount(w);
+    return ret;
+  }
+
+  // First element of s, -1 if empty
+  static int first(const Set &s) {
+    for(size_t w = 0; w < s.size(); w++)
+      if(s[w])
+        return w * 64 + std::countr_zero(s[w]);
+    return -1;
+  }
+
+  static void erase(Set &s, int i) {
+    s[i / 64] &= ~(uint64_t(1) << (i % 64));
+  }
+
+  int degree(int i) const {
+    int ret = 0;
+    for(uint64_t w : row(i))
+      ret += std::popcount(w);
+    return ret;
+  }
+
+  // Neighbors of i inside s
+  int degreeIn(int i, const Set &s) const {
+    std::span<const uint64_t> r = row(i);
+    int ret = 0;
+    for(int w = 0; w < words; w++)
+      ret += std::popcount(r[w] & s[w]);
+    return ret;
+  }
+
+  // Common neighbors of i and j
+  int countCommon(int i, int j) const {
+    std::span<const uint64_t> a = row(i), b = row(j);
+    int ret = 0;
+    for(int w = 0; w < words; w++)
+      ret += std::popcount(a[w] & b[w]);
+    return ret;
+  }
+
+  // s = s & N(i)
+  void keepNeighbors(Set &s, int i) const {
+    std::span<const uint64_t> r = row(i);
+    for(int w = 0; w < words; w++)
+      s[w] &= r[w];
+  }
+
+  // s = s - N[i]
+  void eraseClosed(Set &s, int i) const {
+    std::span<const uint64_t> r = row(i);
+    for(int w = 0; w < words; w++)
+      s[w] &= ~r[w];
+    erase(s, i);
+  }
+
+  // An independent set meets each clique of a cover at most once, so the
+  // number of cliques of a greedy cover of s bounds it from above
+  int cliqueCoverBound(Set s) const {
+    int cliques = 0;
+    Set candidates(resource());
+    for(int i = first(s); i != -1; i = first(s)) {
+      cliques++;
+      candidates.assign(s.begin(), s.end());
+      keepNeighbors(candidates, i);
+      erase(s, i);
+      for(int j = first(candidates); j != -1; j = first(candidates)) {
+        keepNeighbors(candidates, j);
+        erase(s, j);
+      }
+    }
+    return cliques;
+  }
+
+  // Greedy independent set of s by smallest degree inside the remaining set
+  std::pmr::vector<int> greedyIndependent(Set s) const {
+    std::pmr::vector<int> ret(resource());
+    while(true) {
+      int best = -1, bestDegree = 0;
+      for(size_t w = 0; w < s.size(); w++) {
+        for(uint64_t bits = s[w]; bits; bits &= bits - 1) {
+          int i = w * 64 + std::countr_zero(bits);
+          int d = degreeIn(i, s);
+          if(best == -1 || d < bestDegree) {
+            best = i;
+            bestDegree = d;
+          }
+        }
+      }
+      if(best == -1)
+        return ret;
+      ret.push_back(best);
+      eraseClosed(s, best);
+    }
+  }
+};
+
+#endif
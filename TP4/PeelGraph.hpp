@@ -0,0 +1,110 @@
+#ifndef PEEL_GRAPH_HPP
+#define PEEL_GRAPH_HPP
+
+#include <vector>
+#include <algorithm>
+
+// Graph on 0..n-1 that only loses vertices, for greedy peeling. Alive
+// vertices sit in doubly linked lists, one per current degree, so removing
+// a vertex costs O(deg) and a whole peel O(V+E). The min and max degree
+// pointers only move one way between removals, which makes both queries
+// O(1) amortized.
+class PeelGraph {
+  std::vector<int> offsets{0}, targets;
+  std::vector<int> deg, next, prev, head;
+  std::vector<bool> alive;
+  int alives = 0, minDeg = 0, maxDeg = -1;
+
+  void unlink(int v) {
+    if(prev[v] != -1)
+      next[prev[v]] = next[v];
+    else
+      head[deg[v]] = next[v];
+    if(next[v] != -1)
+      prev[next[v]] = prev[v];
+  }
+
+  void link(int v) {
+    prev[v] = -1;
+    next[v] = head[deg[v]];
+    if(next[v] != -1)
+      prev[next[v]] = v;
+    head[deg[v]] = v;
+  }
+
+public:
+  // neighbors(v) gives the neighbors of v as a range of indices
+  template<class F>
+  PeelGraph(int n, F neighbors) : deg(n), next(n), prev(n), alive(n, true), alives(n) {
+    for(int v = 0; v < n; v++) {
+      for(int u : neighbors(v))
+        targets.push_back(u);
+      offsets.push_back(targets.size());
+      deg[v] = offsets[v + 1] - offsets[v];
+      maxDeg = std::max(maxDeg, deg[v]);
+    }
+    head.assign(maxDeg + 1, -1);
+    for(int v = n - 1; v >= 0; v--)
+      link(v);
+  }
+
+  bool empty() const {
+    return alives == 0;
+  }
+
+  int size() const {
+    return alives;
+  }
+
+  bool isAlive(int v) const {
+    return alive[v];
+  }
+
+  // Degree among alive vertices
+  int degree(int v) const {
+    return deg[v];
+  }
+
+  // -1 when empty
+  int minDegreeVertex() {
+    if(empty())
+      return -1;
+    while(head[minDeg] == -1)
+      minDeg++;
+    return head[minDeg];
+  }
+
+  int maxDegreeVertex() {
+    if(empty())
+      return -1;
+    while(head[maxDeg] == -1)
+      maxDeg--;
+    return head[maxDeg];
+  }
+
+  void remove(int v) {
+    if(!alive[v])
+      return;
+    unlink(v);
+    alive[v] = false;
+    alives--;
+    for(int k = offsets[v]; k < offsets[v + 1]; k++) {
+      int u = targets[k];
+      if(alive[u]) {
+        unlink(u);
+        deg[u]--;
+        link(u);
+        minDeg = std::min(minDeg, deg[u]);
+      }
+    }
+  }
+
+  // v and its alive neighbors
+  void removeClosed(int v) {
+    for(int k = offsets[v]; k < offsets[v + 1]; k++)
+      remove(targets[k]);
+    remove(v);
+  }
+};
+
+#endif
@@ -8,9 +8,15 @@
 #include <utility>
 #include <string>
 #include <algorithm>
+#include <ranges>
+#include <span>
+#include <memory_resource>
 
 #include "Graph.hpp"
 #include "SubSolver.hpp"
+#include "BitGraph.hpp"
+#include "PeelGraph.hpp"
+#include "Arena.hpp"
 #include "tools.hpp"
 
 template <class Vertex>
@@ -24,40 +30,43 @@ class Solver
 private:
     Graph<Vertex>& g;
 
-    std::unordered_set<Vertex> independant;
+    FlatSet<Vertex> independant;
     std::vector<Vertex> vertices, vVerticesToBeChecked;
 
+    // Scratch memory of improve(), released at the start of each call.
+    // Phases of improve(), the order of the names given to counter.
+    enum Phase { Bfs, SubGraph, Trim, Bounds };
+    Arena arena;
+    CountingResource counter{{"bfs", "subgraph", "trim", "bounds"}, &arena};
+    long iterations = 0;
+
 public:
     Solver(Graph<Vertex>& _g)
         : g(_g),
-          independant(),
-          vertices(g.vertices().begin(), g.vertices().end()),
-          vVerticesToBeChecked(vertices)
-    {}
+          independant()
+    {
+        std::unordered_set<Vertex> v = g.vertices();
+        vertices = {v.begin(), v.end()};
+        vVerticesToBeChecked = vertices;
+    }
 
+    // Takes a vertex of smallest degree in what is left, then peels it
+    // with its neighbors
     void solve_greedy()
     {
         std::cout << "Solving greedy" << std::endl;
 
-        std::vector<Vertex> queue = vertices;
-        std::sort(queue.begin(), queue.end(),
-            [this](const Vertex& a, const Vertex& b) {
-                return g.degree(a) < g.degree(b);
-            });
-
-        while (!queue.empty()) {
-            Vertex v = queue.front();
-
-            independant.insert(v);
-
-            removeNeighborsFromQueue(queue, v);
-
-            // keep "to be checked" in sync
-            auto it = std::find(vVerticesToBeChecked.begin(),
-                                vVerticesToBeChecked.end(), v);
-            if (it != vVerticesToBeChecked.end())
-                vVerticesToBeChecked.erase(it);
+        PeelGraph peel = peelGraph();
+        while (!peel.empty()) {
+            int i = peel.minDegreeVertex();
+            independant.insert(vertices[i]);
+            peel.removeClosed(i);
         }
+
+        // keep "to be checked" in sync
+        std::erase_if(vVerticesToBeChecked, [&](const Vertex& v) {
+            return independant.contains(v);
+        });
     }
 
     bool improve()
@@ -65,54 +74,98 @@ public:
         if (vVerticesToBeChecked.empty())
             return false;
 
+        arena.reset();
+        iterations++;
+
         Vertex randomVertex = popRandomVertex();
-        auto subVertices = g.bfs(randomVertex, SUB_GRAPH_MAX_SIZE);
+        counter.phase(Bfs);
+        std::pmr::vector<Vertex> subVertices = g.bfs(randomVertex, SUB_GRAPH_MAX_SIZE, &counter);
         int score = countSubIndependant(subVertices);
 
-        Graph<Vertex> subGraph = g.subGraph(subVertices);
+        counter.phase(SubGraph);
+        Graph<Vertex> subGraph = g.subGraph(subVertices, &counter);
+        counter.phase(Trim);
         trimGraph(subGraph, subVertices);
 
-        SubSolver<Vertex> solver(subGraph);
-        if (!solver.solve())
+        // Popcount bound first: nothing to gain unless the clique cover
+        // bound beats the current count
+        counter.phase(Bounds);
+        std::pmr::vector<Vertex> trimmed(&counter);
+        for (const auto& [v, neigh] : subGraph)
+            trimmed.push_back(v);
+        BitGraph<Vertex> bits(g, trimmed, &counter);
+        int bound = bits.cliqueCoverBound(bits.fullSet());
+        if (bound <= score) {
+            checkSubVertices(subVertices);
             return false;
+        }
 
-        std::unordered_set<Vertex> subSolution = solver.independant();
-
-        if (solver.optimal()) {
-            checkSubVertices(subVertices);
+        // The greedy set is kept unless CPLEX beats it, and is optimal
+        // when it meets the bound
+        std::pmr::vector<int> greedy = bits.greedyIndependent(bits.fullSet());
+        std::unordered_set<Vertex> subSolution;
+        for (int i : greedy)
+            subSolution.insert(bits.id(i));
+
+        if ((int)greedy.size() < bound) {
+            SubSolver<Vertex> solver(subGraph);
+            if (solver.solve()) {
+                if (solver.optimal())
+                    checkSubVertices(subVertices);
+                std::unordered_set<Vertex> exact = solver.independant();
+                if (exact.size() > subSolution.size())
+                    subSolution = std::move(exact);
+            }
         }
+        else
+            checkSubVertices(subVertices);
 
-        if (countSubIndependant(subSolution) <= score) {
+        if (subSolution.size() <= (size_t)score) {
             return false;
         }
 
-        removeSubIndependantFrom(solver);
+        removeSubIndependantFrom(subGraph);
         addSubIndependant(subSolution);
         return true;
     }
 
-    const std::unordered_set<Vertex>& solution() const
+    const FlatSet<Vertex>& solution() const
     {
         return independant;
     }
 
+    // Scratch allocations of improve() by phase, per iteration
+    void printAllocations() const
+    {
+        if (iterations == 0)
+            return;
+        std::cout << "Scratch per iteration:";
+        for (size_t p = 0; p < counter.phases.size(); p++)
+            std::cout << " " << counter.phases[p] << " "
+                      << counter.allocations[p] / iterations << " allocations "
+                      << counter.bytes[p] / iterations / 1024 << "KB,";
+        std::cout << " arena " << arena.capacity() / 1024 << "KB" << std::endl;
+    }
+
     bool solved() const
     {
         return vVerticesToBeChecked.empty();
     }
 
 private:
-    void removeNeighborsFromQueue(std::vector<Vertex>& list,
-                                  const Vertex& v) const
+    // Same graph on the indices of vertices
+    PeelGraph peelGraph() const
     {
-        const auto& neighbors = g.closedNeighbors(v);
-        std::erase_if(list,
-            [&](const Vertex& n) {
-                return neighbors.contains(n);
-            });
+        FlatMap<Vertex, int> index;
+        for (int i = 0; i < (int)vertices.size(); i++)
+            index[vertices[i]] = i;
+        return PeelGraph(vertices.size(), [&](int i) {
+            return g.neighbors(vertices[i])
+                | std::views::transform([&](const Vertex& u) { return index.at(u); });
+        });
     }
 
-    void checkSubVertices(const std::vector<Vertex>& subVertices)
+    void checkSubVertices(std::span<const Vertex> subVertices)
     {
         for (const Vertex& v : subVertices) {
         auto it = std::find(vVerticesToBeChecked.begin(),
@@ -122,7 +175,7 @@ private:
     }
     }
 
-    int countSubIndependant(const std::vector<Vertex>& vs) const
+    int countSubIndependant(std::span<const Vertex> vs) const
     {
         int count = 0;
         for (const Vertex& v : vs)
@@ -140,7 +193,7 @@ private:
         return count;
     }
 
-    Vertex popRandomVertex() const
+    Vertex popRandomVertex()
     {
         if (vVerticesToBeChecked.empty())
             throw std::logic_error("popRandomVertex on empty set");
@@ -151,11 +204,11 @@ private:
     }
 
     void trimGraph(Graph<Vertex>& subGraph,
-                   const std::vector<Vertex>& subVertices)
+                   std::span<const Vertex> subVertices)
     {
-        std::unordered_set<Vertex> inSub(subVertices.begin(), subVertices.end());
+        PmrFlatSet<Vertex> inSub(subVertices.begin(), subVertices.end(), subGraph.resource());
 
-        std::erase_if(subGraph.adj, [&](const auto& entry) {
+        erase_if(subGraph.adj, [&](const auto& entry) {
             const Vertex& u = entry.first;
 
             for (const Vertex& n : g.neighbors(u)) {
@@ -164,12 +217,17 @@ private:
             }
             return false;
         });
+
+        // Trimmed vertices must not linger as neighbors, or edges() would
+        // yield endpoints that are no longer vertices of the subgraph
+        for (auto& [u, neigh] : subGraph.adj)
+            erase_if(neigh, [&](const Vertex& n) { return !subGraph.containsVertex(n); });
     }
 
-    void removeSubIndependantFrom(SubSolver<Vertex>& solver)
+    void removeSubIndependantFrom(const Graph<Vertex>& subGraph)
     {
-        std::erase_if(independant, [&](const Vertex& v) {
-            return solver.g.containsVertex(v);
+        erase_if(independant, [&](const Vertex& v) {
+            return subGraph.containsVertex(v);
         });
     }
 
@@ -182,7 +240,7 @@ private:
 // Save the solution to a file
 template <class Vertex>
 void save(const std::string& outfn,
-          const std::unordered_set<Vertex>& solution)
+          const FlatSet<Vertex>& solution)
 {
     std::ofstream outfile(outfn);
     for (Vertex v : solution)
@@ -5,6 +5,7 @@ g++ -o ind-cplex -L/opt/ibm/ILOG/CPLEX_Studio221/cplex/lib/x86-64_linux/static_p
 */
 #include "Solver.hpp"
 #include <iostream>
+#include <filesystem>
 #include <fstream>
 
 using namespace std;
@@ -19,9 +20,11 @@ int main(int argc, char **argv) {
 
   Graph<Vertex> g(argv[1]); // Read input graph
   cout << "Read input graph with " << g.countVertices() << " vertices and "
-                                   << g.countEdges() << " edges" << endl;
+                                   << g.countEdges() << " edges in "
+                                   << g.loadTimes().total << "s (parse " << g.loadTimes().parse
+                                   << "s, build " << g.loadTimes().build << "s)" << endl;
 
-  std::unordered_set<Vertex> solution;
+  FlatSet<Vertex> solution;
 
   while(elapsed() < maxtime) {
     int iterations = 0;
@@ -56,6 +59,7 @@ int main(int argc, char **argv) {
               << " and the best size found is "
               << solution.size()
               << std::endl;
+    solver.printAllocations();
     
     if (solver.solved()) {
       std::cout << std::endl
@@ -65,8 +69,7 @@ int main(int argc, char **argv) {
     }
   }
 
-  string outfn = argv[1]; // Create filename for output
-  outfn.replace(outfn.end()-5, outfn.end(), "ind");
+  string outfn = filesystem::path(argv[1]).replace_extension(".ind"); // Create filename for output
   save(outfn, solution);
   
   return 0;